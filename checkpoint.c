@@ -0,0 +1,206 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Implementation of the checkpoints of the edge swapping chain. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "checkpoint.h"
+
+/*** typedefs(not structures) and defined constants *******/
+
+/** First bytes of a checkpoint, the last one is the version. */
+#define CKPT_MAGIC "USTCKPT3"
+
+/*** structure declarations *******************************/
+
+struct header {
+  char magic[8]; /** CKPT_MAGIC, without the terminator */
+  char forest[8]; /** Name of the backend */
+  uint64_t layout; /** Build flags of the backend, see forestLayout */
+  int64_t V; /** Number of vertexes */
+  int64_t m; /** Number of edges */
+  uint64_t hash; /** Of the edge array, see edgeHash */
+  struct chainState s; /** Position of the chain */
+  uint64_t forestOff; /** Offset of the forest block */
+  uint64_t forestBytes; /** Size of the forest block */
+  uint64_t pOff; /** Offset of P */
+  uint64_t pBytes; /** Size of P */
+};
+
+/*** file scope functions declarations (static) ***********/
+
+/** @return FNV-1a hash of the edges of g. */
+static uint64_t
+edgeHash(graph g /** [in] */
+         );
+
+/** Fills h with the header of a checkpoint of A over g. */
+static void
+makeHeader(struct header* h /** [out] */,
+           forest A /** [in] */,
+           graph g /** [in] */
+           );
+
+/*** implementation ***************************************/
+
+static uint64_t
+edgeHash(graph g
+         )
+{
+  uint64_t h;
+  unsigned char* b;
+  size_t i;
+  size_t n;
+
+  h = 0xcbf29ce484222325ULL;
+  b = (unsigned char*)edges(g);
+  n = edgesNr(g)*sizeof(edge);
+  i = 0;
+  while (i < n) {
+    h ^= b[i];
+    h *= 0x100000001b3ULL;
+    i++;
+  }
+
+  return h;
+}
+
+static void
+makeHeader(struct header* h,
+           forest A,
+           graph g
+           )
+{
+  size_t n;
+
+  memset(h, 0, sizeof(struct header));
+  memcpy(h->magic, CKPT_MAGIC, sizeof(h->magic));
+  n = strlen(forestName(A));
+  memcpy(h->forest, forestName(A), n < sizeof(h->forest) ? n : sizeof(h->forest));
+  h->layout = forestLayout(A);
+  h->V = graphVertexNr(g);
+  h->m = edgesNr(g);
+  h->hash = edgeHash(g);
+  h->forestOff = CKPT_ALIGN;
+  h->forestBytes = forestBytes(A);
+  h->pOff = h->forestOff
+    + (h->forestBytes + CKPT_ALIGN - 1) / CKPT_ALIGN * CKPT_ALIGN;
+  h->pBytes = 2*h->m*sizeof(int);
+}
+
+/* End of Static Functions */
+
+int
+saveCheckpoint(const char* name,
+               forest A,
+               int* P,
+               graph g,
+               struct chainState* s
+               )
+{
+  struct header h;
+  char* tmp;
+  FILE* f;
+  int r;
+
+  makeHeader(&h, A, g);
+  h.s = *s;
+
+  tmp = (char*) malloc(strlen(name) + 5);
+  strcpy(tmp, name);
+  strcat(tmp, ".tmp");
+
+  r = -1;
+  f = fopen(tmp, "w");
+  if (NULL != f) {
+    if (1 == fwrite(&h, sizeof(h), 1, f)
+        && 0 == fseek(f, h.forestOff, SEEK_SET)
+        && 1 == fwrite(forestBlock(A), h.forestBytes, 1, f)
+        && 0 == fseek(f, h.pOff, SEEK_SET)
+        && 1 == fwrite(P, h.pBytes, 1, f)
+        && 0 == fflush(f)
+        && 0 == fsync(fileno(f)))
+      r = 0;
+    if (0 != fclose(f))
+      r = -1;
+    if (0 == r)
+      r = rename(tmp, name);
+    else
+      remove(tmp);
+  }
+  free(tmp);
+
+  return r;
+}
+
+int
+loadCheckpoint(const char* name,
+               forest A,
+               int* P,
+               graph g,
+               struct chainState* s
+               )
+{
+  struct header e; /* Expected */
+  struct header h;
+  FILE* f;
+  int r;
+
+  f = fopen(name, "r");
+  if (NULL == f)
+    return ENOENT == errno ? -1 : -2;
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif /* POSIX_FADV_SEQUENTIAL */
+
+  makeHeader(&e, A, g);
+  r = -2;
+  if (1 == fread(&h, sizeof(h), 1, f)) {
+    r = 1;
+    if (0 == memcmp(e.magic, h.magic, sizeof(h.magic))
+        && 0 == memcmp(e.forest, h.forest, sizeof(h.forest))
+        && e.layout == h.layout && e.V == h.V && e.m == h.m && e.hash == h.hash
+        && e.forestOff == h.forestOff && e.forestBytes == h.forestBytes
+        && e.pOff == h.pOff && e.pBytes == h.pBytes) {
+      r = -2;
+      if (0 == fseek(f, h.forestOff, SEEK_SET)
+          && 1 == fread(forestBlock(A), h.forestBytes, 1, f)
+          && 0 == fseek(f, h.pOff, SEEK_SET)
+          && 1 == fread(P, h.pBytes, 1, f)) {
+        *s = h.s;
+        r = 0;
+      }
+    }
+  }
+  fclose(f);
+
+  return r;
+}
@@ -0,0 +1,90 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Header for the checkpoints of the edge swapping chain.
+
+    A checkpoint file starts with a header, followed by the block of the
+    forest and by the P array, see loadForest. Each section starts at a
+    multiple of CKPT_ALIGN bytes and holds the bytes as they are in memory,
+    so it can be read, or mapped, back without fix-ups. The file is only
+    meant for the machine and build that wrote it. */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "graph.h"
+#include "rng.h"
+#include "dynamicForest.h"
+
+/*** typedefs(not structures) and defined constants *******/
+
+/** Alignment of the sections, a page. */
+#define CKPT_ALIGN 4096
+
+/*** enums ************************************************/
+
+/*** structures declarations (only if really necessary) ***/
+
+/** Position of the chain, besides the forest and P. */
+struct chainState {
+  uint64_t repetition; /** Trees already written */
+  uint64_t steps; /** Steps done towards the next tree */
+  uint64_t output; /** Bytes in the output file */
+  struct rng rng; /** Generator, with the outputs in its buffer, so a
+                      resumed chain draws the same stream it would have
+                      drawn without stopping. */
+};
+
+/*** declarations of public functions (first inlines) *****/
+
+/** Writes the chain to the file name. The file is written under a
+    temporary name and renamed, so a crash leaves the previous checkpoint.
+
+    @return 0 on success, -1 on errors. */
+int
+saveCheckpoint(const char* name /** [in] */,
+               forest A /** [in] */,
+               int* P /** [in] Of 2*edgesNr(g) entries */,
+               graph g /** [in] */,
+               struct chainState* s /** [in] */
+               );
+
+/** Reads the chain from the file name, over A and P, which must have been
+    allocated for g, with the backend used to save them.
+
+    @return 0 on success, -1 if there is no file, -2 if it can not be read
+    or is truncated, and 1 if it belongs to another graph, forest or build
+    of the forest, see forestLayout. */
+int
+loadCheckpoint(const char* name /** [in] */,
+               forest A /** [out] */,
+               int* P /** [out] Of 2*edgesNr(g) entries */,
+               graph g /** [in] */,
+               struct chainState* s /** [out] */
+               );
+
+#endif /* CHECKPOINT_H */
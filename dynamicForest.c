@@ -0,0 +1,642 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "dynamicForest.h"
+#include "linkCutTree.h"
+#include "eulerTourTree.h"
+
+/*** file scope typedefs  *********************************/
+
+struct forestOps { /** Operations of one backend. */
+  const char* name; /** Name used to select it */
+  void (*free)(void* t);
+  void (*display)(void* t, FILE* out);
+  void (*stats)(void* t, FILE* out);
+  int (*vertexNr)(void* t);
+  int (*linkedQ)(void* t, int u, int v);
+  int (*edgeQ)(void* t, int u, int v);
+  void (*link)(void* t, int u, int v, int id);
+  int (*cut)(void* t, int u, int v);
+  int (*cycle)(void* t, int u, int v);
+  void (*pathEdge)(void* t, int u, int v, int k, int* a, int* b);
+  int (*swap)(void* t, int u, int v, int id,
+              uint32_t (*uniform)(void*, uint32_t), void* state,
+              int* a, int* b);
+  void (*build)(void* t, int* parent, int* id);
+  void (*weigh)(void* t, int u, int v, double w); /** NULL if unweighted */
+  int (*weightedSwap)(void* t, int u, int v, int id, double w, double x,
+                      int* a, int* b);
+  size_t (*bytes)(void* t); /** Size of the block of t */
+  uint32_t (*layout)(void); /** Build flags of the block, NULL if none */
+  void* (*clone)(void* t);
+  void (*prefetch)(void* t, int v);
+  int (*above)(void* t, int v);
+  void* (*snapshot)(void* t); /** NULL if there are no snapshots */
+  void (*snapDisplay)(void* s, FILE* out);
+  void (*snapFree)(void* s);
+};
+
+struct forest {
+  const struct forestOps* ops; /** Backend */
+  void* t; /** Backend data structure */
+};
+
+struct forestSnap {
+  const struct forestOps* ops; /** Backend of the forest */
+  void* s; /** Backend snapshot */
+};
+
+/*** file scope functions declarations (static) ***********/
+
+/** Link-Cut tree adapters. */
+static void lctFree(void* t);
+static void lctDisplay(void* t, FILE* out);
+static void lctStats(void* t, FILE* out);
+static int lctVertexNr(void* t);
+static int lctLinkedQ(void* t, int u, int v);
+static int lctEdgeQ(void* t, int u, int v);
+static void lctLink(void* t, int u, int v, int id);
+static int lctCut(void* t, int u, int v);
+static int lctCycle(void* t, int u, int v);
+static void lctPathEdge(void* t, int u, int v, int k, int* a, int* b);
+static int lctSwap(void* t, int u, int v, int id,
+                   uint32_t (*uniform)(void*, uint32_t), void* state,
+                   int* a, int* b);
+static void lctBuild(void* t, int* parent, int* id);
+static void lctWeigh(void* t, int u, int v, double w);
+static int lctWeightedSwap(void* t, int u, int v, int id, double w, double x,
+                           int* a, int* b);
+static size_t lctBytes(void* t);
+static void* lctClone(void* t);
+static void lctPrefetch(void* t, int v);
+static int lctAbove(void* t, int v);
+static void* lctSnapshot(void* t);
+static void lctSnapDisplay(void* s, FILE* out);
+static void lctSnapFree(void* s);
+
+/** Euler tour tree adapters. */
+static void ettFree(void* t);
+static void ettDisplayOp(void* t, FILE* out);
+static void ettStats(void* t, FILE* out);
+static int ettVertexNrOp(void* t);
+static int ettLinkedQOp(void* t, int u, int v);
+static int ettEdgeQOp(void* t, int u, int v);
+static void ettLinkOp(void* t, int u, int v, int id);
+static int ettCutOp(void* t, int u, int v);
+static int ettCycleOp(void* t, int u, int v);
+static void ettPathEdgeOp(void* t, int u, int v, int k, int* a, int* b);
+static int ettSwapOp(void* t, int u, int v, int id,
+                     uint32_t (*uniform)(void*, uint32_t), void* state,
+                     int* a, int* b);
+static void ettBuild(void* t, int* parent, int* id);
+static size_t ettBytesOp(void* t);
+static void* ettClone(void* t);
+static void ettPrefetchOp(void* t, int v);
+static int ettAboveOp(void* t, int v);
+
+/*** file scope variables (static) ************************/
+
+/** Backends, indexed by forestKind. */
+static const struct forestOps backends[] = {
+  {"lct", lctFree, lctDisplay, lctStats, lctVertexNr, lctLinkedQ, lctEdgeQ,
+   lctLink, lctCut, lctCycle, lctPathEdge, lctSwap, lctBuild, lctWeigh,
+   lctWeightedSwap, lctBytes, layoutLCT, lctClone, lctPrefetch, lctAbove, lctSnapshot,
+   lctSnapDisplay, lctSnapFree},
+  {"ett", ettFree, ettDisplayOp, ettStats, ettVertexNrOp, ettLinkedQOp, ettEdgeQOp,
+   ettLinkOp, ettCutOp, ettCycleOp, ettPathEdgeOp, ettSwapOp, ettBuild, NULL,
+   NULL, ettBytesOp, NULL, ettClone, ettPrefetchOp, ettAboveOp, NULL, NULL, NULL}
+};
+
+/*** implementation ***************************************/
+
+static void
+lctFree(void* t)
+{
+  freeLCT((LCT)t);
+}
+
+static void
+lctDisplay(void* t, FILE* out)
+{
+  displayRepTree((LCT)t, out);
+}
+
+static void
+lctStats(void* t, FILE* out)
+{
+  statsLCT((LCT)t, out);
+}
+
+static int
+lctVertexNr(void* t)
+{
+  return vertexNr((LCT)t);
+}
+
+static int
+lctLinkedQ(void* t, int u, int v)
+{
+  return linkedQ((LCT)t, u, v);
+}
+
+static int
+lctEdgeQ(void* t, int u, int v)
+{
+  return edgeQ((LCT)t, u, v);
+}
+
+static void
+lctLink(void* t, int u, int v, int id)
+{
+  link((LCT)t, u, v, id);
+}
+
+static int
+lctCut(void* t, int u, int v)
+{
+  return cut((LCT)t, u, v);
+}
+
+static int
+lctCycle(void* t, int u, int v)
+{
+  return cycle((LCT)t, u, v);
+}
+
+static void
+lctPathEdge(void* t, int u, int v, int k, int* a, int* b)
+{
+  pathEdge((LCT)t, u, v, k, a, b);
+}
+
+static int
+lctSwap(void* t, int u, int v, int id, uint32_t (*uniform)(void*, uint32_t),
+        void* state, int* a, int* b)
+{
+  return swapEdge((LCT)t, u, v, id, uniform, state, a, b);
+}
+
+static void
+lctBuild(void* t, int* parent, int* id)
+{
+  buildLCT((LCT)t, parent, id);
+}
+
+static void
+lctWeigh(void* t, int u, int v, double w)
+{
+  setWeight((LCT)t, u, v, w);
+}
+
+static int
+lctWeightedSwap(void* t, int u, int v, int id, double w, double x,
+                int* a, int* b)
+{
+  return weightedSwap((LCT)t, u, v, id, w, x, a, b);
+}
+
+static size_t
+lctBytes(void* t)
+{
+  return sizeofLCT((LCT)t);
+}
+
+static void*
+lctClone(void* t)
+{
+  return clone((LCT)t);
+}
+
+static void
+lctPrefetch(void* t, int v)
+{
+  prefetchLCT((LCT)t, v);
+}
+
+static int
+lctAbove(void* t, int v)
+{
+  return aboveLCT((LCT)t, v);
+}
+
+static void*
+lctSnapshot(void* t)
+{
+  return snapshotLCT((LCT)t);
+}
+
+static void
+lctSnapDisplay(void* s, FILE* out)
+{
+  displaySnapshot((LCTSnap)s, out);
+}
+
+static void
+lctSnapFree(void* s)
+{
+  freeSnapshot((LCTSnap)s);
+}
+
+static void
+ettFree(void* t)
+{
+  freeETT((ETT)t);
+}
+
+static void
+ettDisplayOp(void* t, FILE* out)
+{
+  ettDisplay((ETT)t, out);
+}
+
+static void
+ettStats(void* t, FILE* out)
+{
+  fprintf(out, "No statistics for Euler tour trees\n");
+}
+
+static int
+ettVertexNrOp(void* t)
+{
+  return ettVertexNr((ETT)t);
+}
+
+static int
+ettLinkedQOp(void* t, int u, int v)
+{
+  return ettLinkedQ((ETT)t, u, v);
+}
+
+static int
+ettEdgeQOp(void* t, int u, int v)
+{
+  return ettEdgeQ((ETT)t, u, v);
+}
+
+static void
+ettLinkOp(void* t, int u, int v, int id)
+{
+  ettLink((ETT)t, u, v, id);
+}
+
+static int
+ettCutOp(void* t, int u, int v)
+{
+  return ettCut((ETT)t, u, v);
+}
+
+static int
+ettCycleOp(void* t, int u, int v)
+{
+  return ettCycle((ETT)t, u, v);
+}
+
+static void
+ettPathEdgeOp(void* t, int u, int v, int k, int* a, int* b)
+{
+  ettPathEdge((ETT)t, u, v, k, a, b);
+}
+
+static int
+ettSwapOp(void* t, int u, int v, int id, uint32_t (*uniform)(void*, uint32_t),
+          void* state, int* a, int* b)
+{
+  return ettSwap((ETT)t, u, v, id, uniform, state, a, b);
+}
+
+static void
+ettBuild(void* t, int* parent, int* id)
+{
+  int i;
+
+  i = 1;
+  while (i <= ettVertexNr((ETT)t)) {
+    if (0 < parent[i])
+      ettLink((ETT)t, parent[i], i, NULL != id ? id[i] : -1);
+    i++;
+  }
+}
+
+static size_t
+ettBytesOp(void* t)
+{
+  return ettBytes((ETT)t);
+}
+
+static void*
+ettClone(void* t)
+{
+  return cloneETT((ETT)t);
+}
+
+static void
+ettPrefetchOp(void* t, int v)
+{
+  ettPrefetch((ETT)t, v);
+}
+
+static int
+ettAboveOp(void* t, int v)
+{
+  return ettAbove((ETT)t, v);
+}
+
+/* End of Static Functions */
+
+forest
+allocForest(forestKind k,
+            int V
+            )
+{
+  forest f;
+
+  f = (forest) malloc(sizeof(struct forest));
+  f->ops = &backends[k];
+  if (FOREST_ETT == k)
+    f->t = allocETT(V);
+  else
+    f->t = allocLCT(V);
+
+  return f;
+}
+
+forest
+cloneForest(forest f
+            )
+{
+  forest c;
+
+  c = (forest) malloc(sizeof(struct forest));
+  c->ops = f->ops;
+  c->t = f->ops->clone(f->t);
+
+  return c;
+}
+
+int
+forestKindOf(const char* s
+             )
+{
+  int k;
+
+  k = sizeof(backends)/sizeof(backends[0]);
+  while (0 < k && 0 != strcmp(s, backends[k-1].name))
+    k--;
+
+  return k-1;
+}
+
+const char*
+forestName(forest f
+           )
+{
+  return f->ops->name;
+}
+
+size_t
+forestBytes(forest f
+            )
+{
+  return f->ops->bytes(f->t);
+}
+
+uint32_t
+forestLayout(forest f
+             )
+{
+  return NULL == f->ops->layout ? 0 : f->ops->layout();
+}
+
+void*
+forestBlock(forest f
+            )
+{
+  return f->t;
+}
+
+void
+freeForest(forest f
+           )
+{
+  f->ops->free(f->t);
+  free(f);
+}
+
+void
+displayForest(forest f,
+              FILE *out
+              )
+{
+  f->ops->display(f->t, out);
+}
+
+void
+forestStats(forest f,
+            FILE *out
+            )
+{
+  f->ops->stats(f->t, out);
+}
+
+int
+forestVertexNr(forest f
+               )
+{
+  return f->ops->vertexNr(f->t);
+}
+
+void
+forestPrefetch(forest f,
+               int v
+               )
+{
+  f->ops->prefetch(f->t, v);
+}
+
+int
+forestAbove(forest f,
+            int v
+            )
+{
+  return f->ops->above(f->t, v);
+}
+
+int
+forestLinkedQ(forest f,
+              int u,
+              int v
+              )
+{
+  return f->ops->linkedQ(f->t, u, v);
+}
+
+int
+forestEdgeQ(forest f,
+            int u,
+            int v
+            )
+{
+  return f->ops->edgeQ(f->t, u, v);
+}
+
+void
+forestLink(forest f,
+           int u,
+           int v,
+           int id
+           )
+{
+  f->ops->link(f->t, u, v, id);
+}
+
+int
+forestCut(forest f,
+          int u,
+          int v
+          )
+{
+  return f->ops->cut(f->t, u, v);
+}
+
+int
+forestCycle(forest f,
+            int u,
+            int v
+            )
+{
+  return f->ops->cycle(f->t, u, v);
+}
+
+void
+forestPathEdge(forest f,
+               int u,
+               int v,
+               int k,
+               int* a,
+               int* b
+               )
+{
+  assert(0 < k && "Edges on the path start at 1");
+  f->ops->pathEdge(f->t, u, v, k, a, b);
+}
+
+int
+forestSwap(forest f,
+           int u,
+           int v,
+           int id,
+           uint32_t (*uniform)(void*, uint32_t),
+           void* state,
+           int* a,
+           int* b
+           )
+{
+  return f->ops->swap(f->t, u, v, id, uniform, state, a, b);
+}
+
+void
+forestBuild(forest f,
+            int* parent,
+            int* id
+            )
+{
+  f->ops->build(f->t, parent, id);
+}
+
+int
+forestWeightedQ(forest f
+                )
+{
+  return NULL != f->ops->weigh;
+}
+
+void
+forestWeigh(forest f,
+            int u,
+            int v,
+            double w
+            )
+{
+  assert(forestWeightedQ(f) && "The backend keeps no weights");
+  f->ops->weigh(f->t, u, v, w);
+}
+
+int
+forestWeightedSwap(forest f,
+                   int u,
+                   int v,
+                   int id,
+                   double w,
+                   double x,
+                   int* a,
+                   int* b
+                   )
+{
+  assert(forestWeightedQ(f) && "The backend keeps no weights");
+  return f->ops->weightedSwap(f->t, u, v, id, w, x, a, b);
+}
+
+int
+forestSnapshotQ(forest f
+                )
+{
+  return NULL != f->ops->snapshot;
+}
+
+forestSnap
+forestSnapshot(forest f
+               )
+{
+  forestSnap s;
+
+  assert(forestSnapshotQ(f) && "Backend without snapshots");
+  s = (forestSnap) malloc(sizeof(struct forestSnap));
+  s->ops = f->ops;
+  s->s = f->ops->snapshot(f->t);
+
+  return s;
+}
+
+void
+displayForestSnap(forestSnap s,
+                  FILE *out
+                  )
+{
+  s->ops->snapDisplay(s->s, out);
+}
+
+void
+freeForestSnap(forestSnap s
+               )
+{
+  s->ops->snapFree(s->s);
+  free(s);
+}
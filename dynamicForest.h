@@ -0,0 +1,268 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+/** @file Header file for the dynamic forest interface.
+
+    The mixing process only needs a few operations on the current spanning
+    tree. This interface hides which data structure implements them, so
+    the backends can be compared on the same Markov chain. */
+
+#ifndef DYNAMICFOREST_H
+#define DYNAMICFOREST_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*** enums ************************************************/
+
+typedef enum {
+  FOREST_LCT, /** Link-Cut tree, see linkCutTree.h */
+  FOREST_ETT  /** Euler tour tree, see eulerTourTree.h */
+} forestKind;
+
+typedef struct forest* forest; /** Dynamic forest abstract data type. */
+
+typedef struct forestSnap* forestSnap; /** Snapshot of the edges of a
+                                           forest. */
+
+/** @return Forest without edges, over vertexes labelled 1 to V */
+forest
+allocForest(forestKind k /**< [in] Backend to use */,
+            int V /**< [in] Number of vertexes of the underlying graph */
+            );
+
+/** @return A copy of f, which evolves independently of f. */
+forest
+cloneForest(forest f /**< [in] */
+            );
+
+/** @return The backend of name s, -1 if there is none. */
+int
+forestKindOf(const char* s /**< [in] "lct" or "ett" */
+             );
+
+/** @return The name of the backend of f, as given to forestKindOf. */
+const char*
+forestName(forest f /** [in] */
+           );
+
+/** @return The number of bytes of the block returned by forestBlock. */
+size_t
+forestBytes(forest f /** [in] */
+            );
+
+/** @return The build flags that change the layout of the block of f,
+    which differs between builds of the same size. 0 for the ETT. */
+uint32_t
+forestLayout(forest f /** [in] */
+             );
+
+/** Both backends keep the whole forest in one block, with indexes instead
+    of pointers. Writing the block and reading it back, or mapping it, over
+    a forest of the same kind and number of vertexes restores the forest.
+
+    @return The block of the backend. */
+void*
+forestBlock(forest f /** [in] */
+            );
+
+/** Free the forest */
+void
+freeForest(forest f /** [in] */
+           );
+
+/** Prints the edges of the forest, followed by a blank line. */
+void
+displayForest(forest f /** [in] */,
+              FILE *out /** [in] */
+              );
+
+/** Prints the operation counters of the backend, if it keeps them. */
+void
+forestStats(forest f /** [in] */,
+            FILE *out /** [in] */
+            );
+
+/** @return Number of vertexes in f. */
+int
+forestVertexNr(forest f /** [in] */
+               );
+
+/** Starts loading the node of vertex v into the cache, without waiting.
+    Lets a caller that knows which vertexes come next overlap the misses
+    with other work. */
+void
+forestPrefetch(forest f /**< [in] */,
+               int v /**< [in] */
+               );
+
+/** @return The node above v, that the operations from v visit next, 0
+    if there is none. The result is a node of the backend, which may not
+    be a vertex, and can be given back to forestPrefetch and forestAbove.
+    Reads the node of v, so call it on a node prefetched earlier. */
+int
+forestAbove(forest f /**< [in] */,
+            int v /**< [in] */
+            );
+
+/** @return 1 if there is a path linking u to v. */
+int
+forestLinkedQ(forest f /**< [in] */,
+              int u /**< [in] */,
+              int v /**< [in] */
+              );
+
+/** @return 1 if (u, v) is an edge of the forest. */
+int
+forestEdgeQ(forest f /**< [in] */,
+            int u /**< [in] */,
+            int v /**< [in] */
+            );
+
+/** Adds the edge (u, v), identified by id.
+    IMPORTANT: u and v must not be linked. */
+void
+forestLink(forest f /**< [in] */,
+           int u /**< [in] */,
+           int v /**< [in] */,
+           int id /**< [in] Returned when the edge is removed */
+           );
+
+/** Removes the edge (u, v).
+
+    @return The id given when it was linked. */
+int
+forestCut(forest f /**< [in] */,
+          int u /**< [in] */,
+          int v /**< [in] */
+          );
+
+/** @return The number of vertexes in the path from u to v.
+    IMPORTANT: u and v must be linked. */
+int
+forestCycle(forest f /**< [in] */,
+            int u /**< [in] */,
+            int v /**< [in] */
+            );
+
+/** Obtains the k-th edge on the path from u to v, *a is the endpoint
+    closer to u.
+    IMPORTANT: Call right after forestCycle(f, u, v), with 1 <= k and k
+    smaller than its result. */
+void
+forestPathEdge(forest f /**< [in] */,
+               int u /**< [in] */,
+               int v /**< [in] */,
+               int k /**< [in] */,
+               int* a /**< [out] */,
+               int* b /**< [out] */
+               );
+
+/** Replaces a uniformly chosen edge of the path from u to v by the edge
+    (u, v). The edge is the k-th from u, with k = 1 + uniform(path edges).
+    IMPORTANT: u and v must be linked, but not adjacent.
+
+    @return The id of the removed edge. */
+int
+forestSwap(forest f /**< [in] */,
+           int u /**< [in] */,
+           int v /**< [in] */,
+           int id /**< [in] Identifier of the new edge (u, v) */,
+           uint32_t (*uniform)(void*, uint32_t) /**< [in] Uniform value
+                                                   in [0, n[ */,
+           void* state /**< [in/out] First argument of uniform */,
+           int* a /**< [out] Removed edge, endpoint closer to u */,
+           int* b /**< [out] Removed edge */
+           );
+
+/** Adds the edges (i, parent[i]) to a forest without edges. The
+    link-cut tree does it in O(V), without exposing any path.
+    IMPORTANT: parent must describe a forest, parent[i] <= 0 for roots. */
+void
+forestBuild(forest f /**< [in] */,
+            int* parent /**< [in] Indexed 1 to V */,
+            int* id /**< [in] Edge identifiers, as parent. -1 for all if
+                       NULL */
+            );
+
+/** @return 1 if the backend keeps edge weights, only the link-cut tree
+    does. */
+int
+forestWeightedQ(forest f /**< [in] */
+                );
+
+/** Sets the weight of the edge (u, v), which must be in the forest. */
+void
+forestWeigh(forest f /**< [in] */,
+            int u /**< [in] */,
+            int v /**< [in] */,
+            double w /**< [in] */
+            );
+
+/** Replaces an edge of the cycle formed by the path from u to v and the
+    new edge (u, v), drawn with probability proportional to the weights,
+    by (u, v). Position x, in [0, 1[, selects the edge in the cumulative
+    weight. See weightedSwap in linkCutTree.h.
+    IMPORTANT: u and v must be linked, but not adjacent.
+
+    @return The id of the removed edge, -1 if the new edge was drawn. */
+int
+forestWeightedSwap(forest f /**< [in] */,
+                   int u /**< [in] */,
+                   int v /**< [in] */,
+                   int id /**< [in] Identifier of the new edge (u, v) */,
+                   double w /**< [in] Weight of the new edge */,
+                   double x /**< [in] */,
+                   int* a /**< [out] Removed edge, endpoint closer to u */,
+                   int* b /**< [out] Removed edge */
+                   );
+
+/** @return 1 if the backend takes snapshots, only the link-cut tree
+    does. */
+int
+forestSnapshotQ(forest f /**< [in] */
+                );
+
+/** @return A snapshot of the edges of f, taken in O(1). While it lives the
+    changes to f cost a little more, see snapshotLCT in linkCutTree.h. */
+forestSnap
+forestSnapshot(forest f /**< [in] */
+               );
+
+/** Prints the edges of the snapshot, as displayForest. It may be called
+    from another thread while the thread of f keeps changing f. */
+void
+displayForestSnap(forestSnap s /**< [in] */,
+                  FILE *out /**< [in] */
+                  );
+
+/** Frees the snapshot, from the thread that changes its forest. */
+void
+freeForestSnap(forestSnap s /**< [in] */
+               );
+
+#endif /* DYNAMICFOREST_H */
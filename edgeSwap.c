@@ -26,11 +26,16 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "graph.h"
-#include "linkCutTree.h"
+#include "rng.h"
+#include "dynamicForest.h"
 #include "mixer.h"
+#include "checkpoint.h"
+#include "hugeAlloc.h"
 
 #define STR_(X) #X
 #define STR(X) STR_(X)
@@ -38,10 +43,60 @@
 int
 main(int argc, char **argv)
 {
-  if(3 != argc && 4 != argc && 5 != argc){
+  int kind = FOREST_LCT; /* Backend of the spanning tree */
+  int jobs = 1; /* Threads of independent chains, after a shared burn-in */
+  int lanes = 0; /* Interleaved chains in each thread, 0 for no -k */
+  int stats = 0; /* Print operation counters at the end */
+  int write = 0; /* Print the trees from a writer thread */
+  char *ckpt = NULL; /* Checkpoint file, NULL for none */
+  long long int every = 0; /* Steps between checkpoints, 0 for one per tree */
+  int pages = HUGE_NONE; /* Pages of the graph and tree, see hugeAlloc.h */
+  int numa = 0; /* Interleave the graph over the NUMA nodes */
+  uint64_t seed = 0; /* Seed of the generator */
+  int seeded = 0; /* Was -s given */
+  struct rng R; /* Random number generator */
+  int format = GRAPH_AUTO; /* Format of <input>, see graph.h */
+  int opt;
+
+  while(-1 != (opt = getopt(argc, argv, "b:c:j:k:n:s:vwH:IF:"))){
+    if('b' == opt)
+      kind = forestKindOf(optarg);
+    else if('H' == opt)
+      pages = hugeKindOf(optarg);
+    else if('I' == opt)
+      numa = 1;
+    else if('c' == opt)
+      ckpt = optarg;
+    else if('n' == opt)
+      every = atoll(optarg);
+    else if('j' == opt)
+      jobs = atoi(optarg);
+    else if('k' == opt)
+      lanes = atoi(optarg);
+    else if('s' == opt){
+      seed = strtoull(optarg, NULL, 10);
+      seeded = 1;
+    }
+    else if('v' == opt)
+      stats = 1;
+    else if('w' == opt)
+      write = 1;
+    else if('F' == opt)
+      format = graphFormatOf(optarg);
+    else
+      kind = -1;
+  }
+  argc -= optind-1;
+  argv += optind-1;
+
+  if((3 != argc && 4 != argc && 5 != argc) || -1 == kind || -1 == pages
+     || -1 == format || 1 > jobs || 0 > lanes
+     || ((1 < jobs || 0 < lanes) && NULL != ckpt)
+     || (write && (1 < jobs || 0 < lanes || NULL != ckpt
+                   || FOREST_LCT != kind))){
     printf("SYNOPSIS\n");
     printf("\n");
-    printf("./edgeSwap <input> <output> [<repetitions> [<extra>]]\n");
+    printf("./edgeSwap [-b lct|ett] [-j <chains> [-k <lanes>]] [-s <seed>] [-v] [-w] [-c <checkpoint> [-n <steps>]] [-H none|thp|2M|1G] [-I] [-F auto|text|snap|metis|mtx] <input> <output> [<repetitions> [<extra>]]\n");
     printf("\n");
     printf("DESCRIPTION\n");
     printf("\n");
@@ -62,6 +117,57 @@ main(int argc, char **argv)
     printf("\n");
     printf("These spanning trees are generated using the edge swapping Markov chain.\n");
     printf("\n");
+    printf("The -b option selects the data structure that stores the current\n");
+    printf("tree, lct for link-cut trees and ett for Euler tour trees. The\n");
+    printf("default is lct.\n");
+    printf("\n");
+    printf("The -j option runs <chains> chains, one per thread. The tree is\n");
+    printf("mixed once and copied to every chain, then each chain writes one\n");
+    printf("tree in turn and draws from its own stream of the generator, so\n");
+    printf("the output does not depend on the scheduling of the threads. It\n");
+    printf("can not be used with -c.\n");
+    printf("\n");
+    printf("The -k option runs <lanes> chains in each thread, or in the only\n");
+    printf("thread without -j. They take turns, one step each, and each one\n");
+    printf("draws its steps ahead and prefetches their memory while the\n");
+    printf("steps before execute. This gives more trees per core on graphs\n");
+    printf("larger than the cache, already with -k 1. The same rules as -j\n");
+    printf("apply.\n");
+    printf("\n");
+    printf("The -v option prints the operation counters of the tree and a\n");
+    printf("histogram of the cycle sizes at the end. The link-cut tree only\n");
+    printf("keeps them when compiled with -D LCT_STATS, see the makefile.\n");
+    printf("\n");
+    printf("The -w option writes each tree from a second thread, from a\n");
+    printf("snapshot of the link-cut tree, while the chain goes on to the\n");
+    printf("next one. The trees are the same as without it. It needs -b lct\n");
+    printf("and can not be used with -j, -k or -c.\n");
+    printf("\n");
+    printf("The -c option saves the state of the chain to the <checkpoint>\n");
+    printf("file after each tree, or every <steps> steps with -n. When the\n");
+    printf("file exists the run resumes from it, with the same arguments,\n");
+    printf("and the <output> file is cut back to the trees it had when the\n");
+    printf("checkpoint was saved.\n");
+    printf("\n");
+    printf("The -F option reads <input> as text, SNAP edge lists, METIS\n");
+    printf("adjacency lists or Matrix Market files, which may be gzipped. By\n");
+    printf("default the format is told by the first bytes of the file, so -F is\n");
+    printf("only needed for METIS files without comment lines, which are\n");
+    printf("otherwise rejected as text.\n");
+    printf("\n");
+    printf("The -H option maps the graph and the tree with transparent huge\n");
+    printf("pages, thp, or with 2M or 1G pages from the hugetlb pool, falling\n");
+    printf("back to smaller pages when these are not available. The -I option\n");
+    printf("interleaves the graph over the NUMA nodes, which helps when -j\n");
+    printf("chains share it. With either option the pages that each array\n");
+    printf("got are printed after loading.\n");
+    printf("\n");
+    printf("The -s option seeds the random number generator, so that runs\n");
+    printf("with the same seed and arguments produce the same trees. Without\n");
+    printf("it a seed is read from /dev/urandom. The seed is printed in both\n");
+    printf("cases. A resumed run continues the generator of the checkpoint\n");
+    printf("and ignores -s.\n");
+    printf("\n");
   } else {
     printf("BSD 2-Clause License\n");
     printf("\n");
@@ -93,6 +199,10 @@ main(int argc, char **argv)
     printf("\n");
     printf("\n");
 
+    if(!seeded)
+      seed = rngEntropy();
+    rngSeed(&R, seed);
+
     unsigned long long int iterations = 1;
     double extra = 0.0;
 
@@ -103,44 +213,169 @@ main(int argc, char **argv)
       }
     }
 
-    unsigned long long int i = 0; /* Number of executions */
     char *fileName = argv[1];
     FILE *fin = fopen(fileName, "r");
-    fileName = argv[2];
-    FILE *fout = fopen(fileName, "w");
+    FILE *fout = NULL;
+    graph G = NULL;
     if(NULL != fin){
-      if(NULL != fout){
-	/* Load graph */
-	graph G = loadGraph(fin);
-	fclose(fin);
+      /* Load graph */
+      hugeSetup(pages, numa);
+      G = loadGraphAs(fin, format);
+      fclose(fin);
+    }
+    if(NULL != G && !graphConnectedQ(G)){
+      printf("Error: the graph is not connected, or has isolated vertexes\n");
+      freeGraph(G);
+    } else if(NULL != G){
+      int m = edgesNr(G);
+
+      int *P = (int *)malloc(2*m*sizeof(int));
+      if(NULL != P){
+	long long int tau = m*(extra+log(m));
+	long long int n; /* Steps until the next checkpoint */
+	struct chainState S; /* Trees written and steps towards the next */
+	forest A = NULL;
+	int resumed = -1;
 
-	int m = edgesNr(G);
+	memset(&S, 0, sizeof(S));
+	if(NULL != ckpt){
+	  A = allocForest(kind, graphVertexNr(G));
+	  resumed = loadCheckpoint(ckpt, A, P, G, &S);
+	}
 
-	int *P = (int *)malloc(2*m*sizeof(int));
-	if(NULL != P){
-	  int tau = m*(extra+log(m));
-	  LCT A = loadLCT(G, P);
+	fileName = argv[2];
+	if(0 == resumed){
+	  fout = fopen(fileName, "r+");
+	  if(NULL != fout && (0 != ftruncate(fileno(fout), S.output)
+			      || 0 != fseek(fout, 0, SEEK_END))){
+	    fclose(fout);
+	    fout = NULL;
+	  }
+	} else if(-1 == resumed)
+	  fout = fopen(fileName, "w");
+
+	if(1 == resumed){
+	  printf("Checkpoint does not match the graph, the -b option or the build\n");
+	} else if(-2 == resumed){
+	  printf("Error reading checkpoint, remove it to start over\n");
+	} else if(NULL != fout){
+	  if(0 == resumed){
+	    printf("Resuming from tree %llu, step %llu.\n",
+		   (unsigned long long)S.repetition,
+		   (unsigned long long)S.steps);
+	    R = S.rng;
+	  } else {
+	    printf("Seed: %llu\n", (unsigned long long)seed);
+	    if(NULL != A)
+	      freeForest(A);
+	    A = loadForest(G, P, kind);
+	  }
+	  if(0 >= every)
+	    every = tau;
+	  if(HUGE_NONE != pages || numa)
+	    hugeReport(stdout);
 
 	  printf("All Ok. Generating trees.\n");
 
-	  while(i < iterations){
-	    printf("%d\n",i);
-	    mixFixed(A, P, G, tau);
-	    displayRepTree(A, fout);
-	    i++;
+	  if(1 < jobs || 0 < lanes){
+	    int chains = jobs*(0 < lanes ? lanes : 1);
+	    forest *C = (forest *)malloc(chains*sizeof(forest));
+	    int **Q = (int **)malloc(chains*sizeof(int *)); /* Their P */
+	    struct rng *X = (struct rng *)malloc(chains*sizeof(struct rng));
+	    int j;
+
+	    mixFixed(A, P, G, tau, &R); /* Burn-in, shared by all chains */
+	    C[0] = A;
+	    Q[0] = P;
+	    X[0] = R;
+	    rngJump(&X[0]);
+	    j = 1;
+	    while(j < chains){
+	      C[j] = cloneForest(A);
+	      Q[j] = (int *)malloc(2*m*sizeof(int));
+	      memcpy(Q[j], P, 2*m*sizeof(int));
+	      X[j] = X[j-1];
+	      rngJump(&X[j]);
+	      j++;
+	    }
+
+	    while(S.repetition < iterations){
+	      printf("%llu\n", (unsigned long long)S.repetition);
+	      n = iterations - S.repetition;
+	      if(chains < n)
+		n = chains;
+	      mixChains(C, Q, G, tau, n, lanes, X);
+	      j = 0;
+	      while(j < n){
+		displayForest(C[j], fout);
+		S.repetition++;
+		j++;
+	      }
+	    }
+
+	    j = 1;
+	    while(j < chains){
+	      freeForest(C[j]);
+	      free(Q[j]);
+	      j++;
+	    }
+	    free(X);
+	    free(Q);
+	    free(C);
+	  }
+
+	  treeWriter W = NULL;
+	  if(write)
+	    W = startWriter(A, fout);
+	  while(S.repetition < iterations){
+	    printf("%llu\n", (unsigned long long)S.repetition);
+	    while(S.steps < tau){
+	      n = tau - S.steps;
+	      if(every < n)
+		n = every;
+	      mixFixed(A, P, G, n, &R);
+	      S.steps += n;
+	      if(NULL != ckpt && S.steps < tau){
+		S.rng = R;
+		if(0 != saveCheckpoint(ckpt, A, P, G, &S))
+		  printf("Error writing checkpoint\n");
+	      }
+	    }
+	    if(NULL != W)
+	      writeTree(W);
+	    else
+	      displayForest(A, fout);
+	    S.repetition++;
+	    S.steps = 0;
+	    if(NULL != ckpt){
+	      fflush(fout);
+	      fsync(fileno(fout));
+	      S.output = ftell(fout);
+	      S.rng = R;
+	      if(0 != saveCheckpoint(ckpt, A, P, G, &S))
+		printf("Error writing checkpoint\n");
+	    }
 	  }
+	  if(NULL != W)
+	    stopWriter(W);
 	  fclose(fout);
 
-	  free(P);
-	  freeLCT(A);
-	} else {
-	  printf("Error reading graph\n");
-	}
-	freeGraph(G);
-      } else
-	printf("Error opening output file\n");
-    } else
+	  if(stats)
+	    forestStats(A, stdout);
+	} else
+	  printf("Error opening output file\n");
+
+	free(P);
+	if(NULL != A)
+	  freeForest(A);
+      } else {
+	printf("Error reading graph\n");
+      }
+      freeGraph(G);
+    } else if(NULL == fin)
       printf("Error opening input file\n");
+    else
+      printf("Error reading input file\n");
   }
 }
 
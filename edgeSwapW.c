@@ -0,0 +1,203 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "rng.h"
+#include "dynamicForest.h"
+#include "mixer.h"
+#include "hugeAlloc.h"
+
+#define STR_(X) #X
+#define STR(X) STR_(X)
+
+int
+main(int argc, char **argv)
+{
+  int stats = 0; /* Print operation counters at the end */
+  int pages = HUGE_NONE; /* Pages of the graph and tree, see hugeAlloc.h */
+  int numa = 0; /* Interleave the graph over the NUMA nodes */
+  uint64_t seed = 0; /* Seed of the generator */
+  int seeded = 0; /* Was -s given */
+  struct rng X; /* Random number generator */
+  int opt;
+
+  while(-1 != (opt = getopt(argc, argv, "s:vH:I"))){
+    if('v' == opt)
+      stats = 1;
+    else if('H' == opt)
+      pages = hugeKindOf(optarg);
+    else if('I' == opt)
+      numa = 1;
+    else if('s' == opt){
+      seed = strtoull(optarg, NULL, 10);
+      seeded = 1;
+    }
+    else
+      argc = 0; /* Print the synopsis */
+  }
+  argc -= optind-1;
+  argv += optind-1;
+
+  if((3 != argc && 4 != argc && 5 != argc) || -1 == pages){
+    printf("SYNOPSIS\n");
+    printf("\n");
+    printf("./edgeSwapW [-s <seed>] [-v] [-H none|thp|2M|1G] [-I] <input> <output> [<repetitions> [<extra>]]\n");
+    printf("\n");
+    printf("DESCRIPTION\n");
+    printf("\n");
+    printf("Weighted version of edgeSwap. Each edge of the <input> graph is\n");
+    printf("followed by a positive weight, a floating point value. The spanning\n");
+    printf("trees are sampled with probability proportional to the product of\n");
+    printf("the weights of their edges. The remaining arguments are as in\n");
+    printf("edgeSwap.\n");
+    printf("\n");
+    printf("Each step of the chain draws a non tree edge uniformly and removes\n");
+    printf("an edge of the cycle it closes, the new edge included, with\n");
+    printf("probability proportional to the inverse of its weight.\n");
+    printf("\n");
+    printf("The -v option prints the operation counters of the tree and a\n");
+    printf("histogram of the cycle sizes at the end, see edgeSwap.\n");
+    printf("\n");
+    printf("The -H and -I options choose the pages of the graph and of the\n");
+    printf("tree, see edgeSwap.\n");
+    printf("\n");
+    printf("The -s option seeds the random number generator, see edgeSwap.\n");
+    printf("\n");
+  } else {
+    printf("BSD 2-Clause License\n");
+    printf("\n");
+    printf("Copyright (c) 2020, Luís M. S. Russo\n");
+    printf("All rights reserved.\n");
+    printf("\n");
+    printf("Redistribution and use in source and binary forms, with or without\n");
+    printf("modification, are permitted provided that the following conditions are met:\n");
+    printf("\n");
+    printf("1. Redistributions of source code must retain the above copyright notice, this\n");
+    printf("   list of conditions and the following disclaimer.\n");
+    printf("\n");
+    printf("2. Redistributions in binary form must reproduce the above copyright notice,\n");
+    printf("   this list of conditions and the following disclaimer in the documentation\n");
+    printf("   and/or other materials provided with the distribution.\n");
+    printf("\n");
+    printf("THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS \"AS IS\"\n");
+    printf("AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE\n");
+    printf("IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE\n");
+    printf("DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE\n");
+    printf("FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL\n");
+    printf("DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR\n");
+    printf("SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER\n");
+    printf("CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,\n");
+    printf("OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE\n");
+    printf("OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.\n");
+    printf("\n");
+    printf("Weighted Random Walk generator, version %s\n", STR(_LIBUSTREE_VERSION) );
+    printf("\n");
+    printf("\n");
+
+    if(!seeded)
+      seed = rngEntropy();
+    rngSeed(&X, seed);
+
+    unsigned long long int iterations = 1;
+    double extra = 0.0;
+
+    if(4 <= argc){
+      sscanf(argv[3], "%ld", &iterations);  /* Read number of iterations */
+      if(5 == argc){
+	sscanf(argv[4], "%lf", &extra);  /* Read extra steps */
+      }
+    }
+
+    unsigned long long int i = 0; /* Number of executions */
+    char *fileName = argv[1];
+    FILE *fin = fopen(fileName, "r");
+    fileName = argv[2];
+    FILE *fout = fopen(fileName, "w");
+    if(NULL != fin){
+      if(NULL != fout){
+	/* Load graph */
+	double *R; /* Weights, then resistances */
+	hugeSetup(pages, numa);
+	graph G = loadWeightedGraph(fin, &R);
+	fclose(fin);
+
+	if(NULL == G){
+	  printf("Error reading input file\n");
+	  fclose(fout);
+	} else if(!graphConnectedQ(G)){
+	  printf("Error: the graph is not connected, or has isolated vertexes\n");
+	  fclose(fout);
+	  freeGraph(G);
+	  free(R);
+	} else {
+	  int m = edgesNr(G);
+	  int j = 0;
+	  while(j < m){
+	    R[j] = 1/R[j];
+	    j++;
+	  }
+
+	  int *P = (int *)malloc(2*m*sizeof(int));
+	  if(NULL != P){
+	    long long int tau = m*(extra+log(m));
+	    forest A = loadForest(G, P, FOREST_LCT);
+	    weighForest(A, P, G, R);
+	    if(HUGE_NONE != pages || numa)
+	      hugeReport(stdout);
+
+	    printf("Seed: %llu\n", (unsigned long long)seed);
+	    printf("All Ok. Generating trees.\n");
+
+	    while(i < iterations){
+	      printf("%llu\n",i);
+	      mixWeighted(A, P, G, R, tau, &X);
+	      displayForest(A, fout);
+	      i++;
+	    }
+	    fclose(fout);
+
+	    if(stats)
+	      forestStats(A, stdout);
+
+	    free(P);
+	    freeForest(A);
+	  } else {
+	    printf("Error reading graph\n");
+	  }
+	  free(R);
+	  freeGraph(G);
+	}
+      } else
+	printf("Error opening output file\n");
+    } else
+      printf("Error opening input file\n");
+  }
+}
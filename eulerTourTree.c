@@ -0,0 +1,951 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "eulerTourTree.h"
+#include "hugeAlloc.h"
+
+/*** file scope macro definitions *************************/
+
+/* Nodes 1 to V are the vertexes. The arcs come in pairs after them, pair j
+   is nodes V+1+2j and V+2+2j. Index 0 is the NULL node. */
+#define NODE(t, v) (((struct node*)&(t)[1])[v])
+#define LEFT(t, v) (NODE(t, v).left)
+#define RIGHT(t, v) (NODE(t, v).right)
+#define PARENT(t, v) (NODE(t, v).parent)
+#define SIZE(t, v) (NODE(t, v).size)
+#define VAL(t, v) (NODE(t, v).val)
+#define SUM(t, v) (NODE(t, v).sum)
+#define MINP(t, v) (NODE(t, v).minp)
+#define ID(t, v) (NODE(t, v).id)
+
+/* Number of nodes, without the NULL node */
+#define NODES(V) ((V) + 2*((V) > 1 ? (V)-1 : 0))
+
+/* Endpoints of the arc pairs, after the nodes. Pair j is (E[2j],E[2j+1]),
+   E[2j] is 0 when the pair is free. */
+#define ENDS(t) ((int32_t*)&NODE(t, NODES((t)->V)+1))
+
+/* Larger than any prefix sum, small enough to be added to one. */
+#define NOMIN (1 << 29)
+
+/*** file scope typedefs  *********************************/
+
+struct node { /** This structure is used to represent a node in the tour. */
+  uint32_t left; /** Child */
+  uint32_t right; /** Child */
+  uint32_t parent; /** Parent index. 0 at the root of the treap. */
+  int32_t size; /** Number of nodes in this sub-tree. */
+  int32_t val; /** +1 for arcs away from the root, -1 for arcs towards it
+                   and 0 for vertexes. */
+  int32_t sum; /** Sum of val over this sub-tree. */
+  int32_t minp; /** Minimum prefix sum of val over this sub-tree. */
+  int32_t id; /** Identifier of the edge, on both of its arcs. */
+};
+
+struct ETT { /** Header, the arrays follow it in the same block. */
+  int32_t V; /** Number of vertexes */
+  int32_t free; /** First free arc pair plus 1, or 0. The list continues
+                    on E[2j+1]. */
+  uint32_t pad[2]; /** Keeps the nodes 16 byte aligned */
+};
+
+/*** global variables (externs or externables) ************/
+
+/*** file scope variables (static) ************************/
+
+/*** file scope functions declarations (static) ***********/
+
+/** @return The number of bytes of an ETT over V vertexes. */
+static size_t
+bytesETT(int V /**< [in] */
+         );
+
+/** Recomputes size, sum and minp of x from its children. */
+static void
+update(ETT t /**< [in] */,
+       uint32_t x /**< [in] */
+       );
+
+/** @return Pseudo random priority of x. */
+static uint32_t
+priority(uint32_t x /**< [in] */
+         );
+
+/** @return The root of the treap containing x. */
+static uint32_t
+rootOf(ETT t /**< [in] */,
+       uint32_t x /**< [in] */
+       );
+
+/** @return The position of x in its tour, starting at 0. */
+static int
+rank(ETT t /**< [in] */,
+     uint32_t x /**< [in] */
+     );
+
+/** @return The prefix sum up to x, inclusive. For vertexes the depth. */
+static int
+prefix(ETT t /**< [in] */,
+       uint32_t x /**< [in] */
+       );
+
+/** @return The root of the concatenation of a and b. */
+static uint32_t
+merge(ETT t /**< [in] */,
+      uint32_t a /**< [in] */,
+      uint32_t b /**< [in] */
+      );
+
+/** Splits the treap x, the first k nodes go to *a, the others to *b. */
+static void
+split(ETT t /**< [in] */,
+      uint32_t x /**< [in] */,
+      int k /**< [in] */,
+      uint32_t* a /**< [out] */,
+      uint32_t* b /**< [out] */
+      );
+
+/** @return The node at position k of treap x, starting at 0. */
+static uint32_t
+nodeAt(ETT t /**< [in] */,
+       uint32_t x /**< [in] */,
+       int k /**< [in] */
+       );
+
+/** @return The last position of treap x with off plus its prefix sum at
+    most D, -1 if none. */
+static int
+lastAtMost(ETT t /**< [in] */,
+           uint32_t x /**< [in] */,
+           int D /**< [in] */,
+           int off /**< [in] Sum of the nodes before x */
+           );
+
+/** @return As lastAtMost, among the first k positions of treap x. */
+static int
+lastBefore(ETT t /**< [in] */,
+           uint32_t x /**< [in] */,
+           int k /**< [in] */,
+           int D /**< [in] */,
+           int off /**< [in] Sum of the nodes before x */
+           );
+
+/** @return The minimum of off plus the prefix sums at positions i to j-1
+    of treap x, NOMIN plus off if there are none. */
+static int
+minIn(ETT t /**< [in] */,
+      uint32_t x /**< [in] */,
+      int i /**< [in] */,
+      int j /**< [in] */,
+      int off /**< [in] Sum of the nodes before x */
+      );
+
+/** Turns the arcs of treap x that go down the path to the new root into
+    arcs going up. These are the arcs where the minimum prefix sum from
+    them to the end of the tour, fm included, goes up. Only the sub-trees
+    that hold such arcs are visited, and updated on the way back. */
+static void
+flipOpen(ETT t /**< [in] */,
+         uint32_t x /**< [in] Tour before the new root */,
+         int off /**< [in] Sum of the nodes before x */,
+         int fm /**< [in] Minimum prefix sum after x */
+         );
+
+/** Turns the arcs of treap x that come up the path from the new root into
+    arcs going down, the arcs where the minimum prefix sum goes down. As
+    flipOpen. */
+static void
+flipClose(ETT t /**< [in] */,
+          uint32_t x /**< [in] Tour from the new root on */,
+          int off /**< [in] Sum of the nodes before x */,
+          int m /**< [in] Minimum prefix sum before x */
+          );
+
+/** @return The arc leading into the ancestor of v at depth d.
+    IMPORTANT: 1 <= d <= depth of v. */
+static uint32_t
+opener(ETT t /**< [in] */,
+       int v /**< [in] */,
+       int d /**< [in] */
+       );
+
+/** @return The other arc of the pair. */
+static uint32_t
+partner(ETT t /**< [in] */,
+        uint32_t x /**< [in] */
+        );
+
+/** @return Origin vertex of arc x. */
+static int
+from(ETT t /**< [in] */,
+     uint32_t x /**< [in] */
+     );
+
+/** @return Destination vertex of arc x. */
+static int
+to(ETT t /**< [in] */,
+   uint32_t x /**< [in] */
+   );
+
+/** Changes the root of the tree of v to v. The tour is rotated to start
+    at v, with one split and one merge, and the arcs of the path from the
+    old root to v change direction in one pass over each part. */
+static void
+reRootETT(ETT t /**< [in] */,
+          int v /**< [in] */
+          );
+
+/** Removes the edge of arc o, which goes from a parent to its child.
+
+    @return The id of the edge. */
+static int
+cutArc(ETT t /**< [in] */,
+       uint32_t o /**< [in] */
+       );
+
+/** @return The depth of the lowest common ancestor of u and v. */
+static int
+lcaDepth(ETT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */
+         );
+
+/*** implementation ***************************************/
+
+static void
+update(ETT t,
+       uint32_t x
+       )
+{
+  uint32_t l;
+  uint32_t r;
+  int s;
+  int m;
+
+  l = LEFT(t, x);
+  r = RIGHT(t, x);
+
+  SIZE(t, x) = 1 + SIZE(t, l) + SIZE(t, r);
+  s = SUM(t, l) + VAL(t, x);
+  m = MINP(t, l);
+  if (s < m)
+    m = s;
+  if (s + MINP(t, r) < m)
+    m = s + MINP(t, r);
+  SUM(t, x) = s + SUM(t, r);
+  MINP(t, x) = m;
+}
+
+static uint32_t
+priority(uint32_t x
+         )
+{
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+
+  return x;
+}
+
+static uint32_t
+rootOf(ETT t,
+       uint32_t x
+       )
+{
+  while (0 != PARENT(t, x))
+    x = PARENT(t, x);
+
+  return x;
+}
+
+static int
+rank(ETT t,
+     uint32_t x
+     )
+{
+  int r;
+  uint32_t p;
+
+  r = SIZE(t, LEFT(t, x));
+  while (0 != PARENT(t, x)) {
+    p = PARENT(t, x);
+    if (x == RIGHT(t, p))
+      r += SIZE(t, LEFT(t, p)) + 1;
+    x = p;
+  }
+
+  return r;
+}
+
+static int
+prefix(ETT t,
+       uint32_t x
+       )
+{
+  int s;
+  uint32_t p;
+
+  s = SUM(t, LEFT(t, x)) + VAL(t, x);
+  while (0 != PARENT(t, x)) {
+    p = PARENT(t, x);
+    if (x == RIGHT(t, p))
+      s += SUM(t, LEFT(t, p)) + VAL(t, p);
+    x = p;
+  }
+
+  return s;
+}
+
+static uint32_t
+merge(ETT t,
+      uint32_t a,
+      uint32_t b
+      )
+{
+  uint32_t r;
+
+  r = a;
+  if (0 == a)
+    r = b;
+  else if (0 != b) {
+    if (priority(a) > priority(b)) {
+      RIGHT(t, a) = merge(t, RIGHT(t, a), b);
+      PARENT(t, RIGHT(t, a)) = a;
+    } else {
+      r = b;
+      LEFT(t, b) = merge(t, a, LEFT(t, b));
+      PARENT(t, LEFT(t, b)) = b;
+    }
+    update(t, r);
+  }
+
+  return r;
+}
+
+static void
+split(ETT t,
+      uint32_t x,
+      int k,
+      uint32_t* a,
+      uint32_t* b
+      )
+{
+  uint32_t c; /* Part that stays below x */
+
+  if (0 == x) {
+    *a = 0;
+    *b = 0;
+  } else if (SIZE(t, LEFT(t, x)) >= k) {
+    split(t, LEFT(t, x), k, a, &c);
+    LEFT(t, x) = c;
+    if (0 != c)
+      PARENT(t, c) = x;
+    update(t, x);
+    *b = x;
+  } else {
+    split(t, RIGHT(t, x), k - SIZE(t, LEFT(t, x)) - 1, &c, b);
+    RIGHT(t, x) = c;
+    if (0 != c)
+      PARENT(t, c) = x;
+    update(t, x);
+    *a = x;
+  }
+  if (0 != *a)
+    PARENT(t, *a) = 0;
+  if (0 != *b)
+    PARENT(t, *b) = 0;
+}
+
+static uint32_t
+nodeAt(ETT t,
+       uint32_t x,
+       int k
+       )
+{
+  while (SIZE(t, LEFT(t, x)) != k) {
+    if (SIZE(t, LEFT(t, x)) > k)
+      x = LEFT(t, x);
+    else {
+      k -= SIZE(t, LEFT(t, x)) + 1;
+      x = RIGHT(t, x);
+    }
+  }
+
+  return x;
+}
+
+static int
+lastAtMost(ETT t,
+           uint32_t x,
+           int D,
+           int off
+           )
+{
+  int r;
+  int s; /* Prefix sum at x */
+
+  r = -1;
+  if (0 != x && off + MINP(t, x) <= D) {
+    s = off + SUM(t, LEFT(t, x)) + VAL(t, x);
+    r = lastAtMost(t, RIGHT(t, x), D, s);
+    if (0 <= r)
+      r += SIZE(t, LEFT(t, x)) + 1;
+    else if (s <= D)
+      r = SIZE(t, LEFT(t, x));
+    else
+      r = lastAtMost(t, LEFT(t, x), D, off);
+  }
+
+  return r;
+}
+
+static int
+lastBefore(ETT t,
+           uint32_t x,
+           int k,
+           int D,
+           int off
+           )
+{
+  int r;
+  int s; /* Prefix sum at x */
+  int sl;
+
+  r = -1;
+  if (0 != x && 0 < k) {
+    sl = SIZE(t, LEFT(t, x));
+    if (k >= SIZE(t, x))
+      r = lastAtMost(t, x, D, off);
+    else if (k <= sl)
+      r = lastBefore(t, LEFT(t, x), k, D, off);
+    else {
+      s = off + SUM(t, LEFT(t, x)) + VAL(t, x);
+      r = lastBefore(t, RIGHT(t, x), k - sl - 1, D, s);
+      if (0 <= r)
+        r += sl + 1;
+      else if (s <= D)
+        r = sl;
+      else
+        r = lastAtMost(t, LEFT(t, x), D, off);
+    }
+  }
+
+  return r;
+}
+
+static int
+minIn(ETT t,
+      uint32_t x,
+      int i,
+      int j,
+      int off
+      )
+{
+  int m;
+  int s; /* Prefix sum at x */
+  int sl;
+
+  if (0 == x || j <= 0 || i >= SIZE(t, x))
+    return off + NOMIN;
+  if (i <= 0 && j >= SIZE(t, x))
+    return off + MINP(t, x);
+
+  sl = SIZE(t, LEFT(t, x));
+  s = off + SUM(t, LEFT(t, x)) + VAL(t, x);
+  m = minIn(t, LEFT(t, x), i, j, off);
+  if (i <= sl && sl < j && s < m)
+    m = s;
+  s = minIn(t, RIGHT(t, x), i - sl - 1, j - sl - 1, s);
+
+  return s < m ? s : m;
+}
+
+static void
+flipOpen(ETT t,
+         uint32_t x,
+         int off,
+         int fm
+         )
+{
+  uint32_t l;
+  uint32_t r;
+  int px; /* Prefix sum at x */
+  int fr; /* Minimum prefix sum after x */
+  int lo;
+  int hi;
+
+  if (0 == x)
+    return;
+  lo = off + MINP(t, x) < off ? off + MINP(t, x) : off;
+  lo = fm < lo ? fm : lo;
+  hi = off + SUM(t, x) < fm ? off + SUM(t, x) : fm;
+  if (lo >= hi) /* The minimum after x does not go up inside x */
+    return;
+
+  l = LEFT(t, x);
+  r = RIGHT(t, x);
+  px = off + SUM(t, l) + VAL(t, x);
+  fr = px + MINP(t, r) < fm ? px + MINP(t, r) : fm;
+  flipOpen(t, r, px, fm);
+  if (1 == VAL(t, x) && px <= fr)
+    VAL(t, x) = -1;
+  flipOpen(t, l, off, px < fr ? px : fr);
+  update(t, x);
+}
+
+static void
+flipClose(ETT t,
+          uint32_t x,
+          int off,
+          int m
+          )
+{
+  uint32_t l;
+  uint32_t r;
+  int px; /* Prefix sum at x */
+  int ml; /* Minimum prefix sum before x */
+
+  if (0 == x || off + MINP(t, x) >= m) /* Never below m inside x */
+    return;
+
+  l = LEFT(t, x);
+  r = RIGHT(t, x);
+  px = off + SUM(t, l) + VAL(t, x);
+  ml = off + MINP(t, l) < m ? off + MINP(t, l) : m;
+  flipClose(t, l, off, m);
+  if (-1 == VAL(t, x) && px < ml)
+    VAL(t, x) = 1;
+  flipClose(t, r, px, px < ml ? px : ml);
+  update(t, x);
+}
+
+static uint32_t
+opener(ETT t,
+       int v,
+       int d
+       )
+{
+  uint32_t a; /* Its tour */
+
+  a = rootOf(t, v);
+  return nodeAt(t, a, lastBefore(t, a, rank(t, v), d-1, 0) + 1);
+}
+
+static uint32_t
+partner(ETT t,
+        uint32_t x
+        )
+{
+  return ((x - t->V - 1) ^ 1) + t->V + 1;
+}
+
+static int
+from(ETT t,
+     uint32_t x
+     )
+{
+  x -= t->V + 1;
+  return ENDS(t)[x];
+}
+
+static int
+to(ETT t,
+   uint32_t x
+   )
+{
+  x -= t->V + 1;
+  return ENDS(t)[x ^ 1];
+}
+
+static void
+reRootETT(ETT t,
+          int v
+          )
+{
+  uint32_t a; /* Tour before v */
+  uint32_t b; /* Tour from v on */
+  int d;
+
+  if (0 != rank(t, v)) {
+    d = prefix(t, v);
+    split(t, rootOf(t, v), rank(t, v), &a, &b);
+    if (0 < d) { /* The arcs that straddle v */
+      flipOpen(t, a, 0, d);
+      flipClose(t, b, d, d);
+    }
+    merge(t, b, a);
+  }
+}
+
+static int
+lcaDepth(ETT t,
+         int u,
+         int v
+         )
+{
+  int pu;
+  int pv;
+  int r;
+
+  pu = rank(t, u);
+  pv = rank(t, v);
+  if (pv < pu) {
+    r = pu;
+    pu = pv;
+    pv = r;
+  }
+
+  return minIn(t, rootOf(t, u), pu, pv+1, 0);
+}
+
+static size_t
+bytesETT(int V
+         )
+{
+  int N;
+
+  N = NODES(V);
+  return sizeof(struct ETT) + (N+1)*sizeof(struct node)
+    + (N-V)*sizeof(int32_t);
+}
+
+/* End of Static Functions */
+
+ETT
+allocETT(int V
+         )
+{
+  ETT t;
+  int N;
+  int i;
+
+  N = NODES(V);
+  t = (ETT) hugeAlloc(bytesETT(V), 0, "Euler tour tree");
+  t->V = V;
+
+  memset(&NODE(t, 0), 0, (N+1)*sizeof(struct node));
+  MINP(t, 0) = NOMIN;
+  i = 1;
+  while (i <= N) {
+    update(t, i);
+    i++;
+  }
+
+  t->free = 0;
+  i = (N-V)/2;
+  while (0 < i) { /* All pairs are free */
+    i--;
+    ENDS(t)[2*i] = 0;
+    ENDS(t)[2*i+1] = t->free;
+    t->free = i+1;
+  }
+
+  return t;
+}
+
+void
+freeETT(ETT t
+        )
+{
+  hugeFree(t);
+}
+
+ETT
+cloneETT(ETT t
+         )
+{
+  ETT c;
+  size_t s;
+
+  s = bytesETT(t->V);
+  c = (ETT) hugeAlloc(s, 0, "Euler tour tree");
+  memcpy(c, t, s); /* Indexes need no relocation */
+
+  return c;
+}
+
+size_t
+ettBytes(ETT t
+         )
+{
+  return bytesETT(t->V);
+}
+
+int
+ettVertexNr(ETT t
+            )
+{
+  return t->V;
+}
+
+void
+ettPrefetch(ETT t,
+            int v
+            )
+{
+  __builtin_prefetch(&NODE(t, v));
+}
+
+int
+ettAbove(ETT t,
+         int v
+         )
+{
+  return PARENT(t, v);
+}
+
+int
+ettLinkedQ(ETT t,
+           int u,
+           int v
+           )
+{
+  return rootOf(t, u) == rootOf(t, v);
+}
+
+int
+ettEdgeQ(ETT t,
+         int u,
+         int v
+         )
+{
+  int r;
+  int du;
+  int dv;
+
+  r = 0;
+  if (u != v && ettLinkedQ(t, u, v)) {
+    du = prefix(t, u);
+    dv = prefix(t, v);
+    if (du == dv + 1)
+      r = (v == from(t, opener(t, u, du)));
+    else if (dv == du + 1)
+      r = (u == from(t, opener(t, v, dv)));
+  }
+
+  return r;
+}
+
+void
+ettLink(ETT t,
+        int u,
+        int v,
+        int id
+        )
+{
+  uint32_t o; /* Arc from u to v */
+  uint32_t q; /* Arc from v to u */
+  uint32_t a;
+  uint32_t b;
+  int j;
+
+  assert(u != v && "Linking no edge");
+  assert(!ettLinkedQ(t, u, v) && "Link failed. Trees already linked.");
+  assert(0 != t->free && "No free arcs");
+
+  if (prefix(t, v) > prefix(t, u)) { /* Re-root the shallower vertex */
+    j = u;
+    u = v;
+    v = j;
+  }
+  reRootETT(t, v);
+
+  j = t->free - 1;
+  t->free = ENDS(t)[2*j+1];
+  ENDS(t)[2*j] = u;
+  ENDS(t)[2*j+1] = v;
+
+  o = t->V + 1 + 2*j;
+  q = o + 1;
+  LEFT(t, o) = RIGHT(t, o) = PARENT(t, o) = 0;
+  LEFT(t, q) = RIGHT(t, q) = PARENT(t, q) = 0;
+  VAL(t, o) = 1;
+  VAL(t, q) = -1;
+  ID(t, o) = id;
+  ID(t, q) = id;
+  update(t, o);
+  update(t, q);
+
+  /* The tour of v goes right after u */
+  split(t, rootOf(t, u), rank(t, u)+1, &a, &b);
+  merge(t, merge(t, merge(t, merge(t, a, o), rootOf(t, v)), q), b);
+}
+
+int
+ettCut(ETT t,
+       int u,
+       int v
+       )
+{
+  int r;
+  int j;
+
+  assert(u != v && "Cutting no edge");
+  assert(ettEdgeQ(t, u, v) && "Cutting edges that are not there");
+
+  r = -1;
+  if (ettEdgeQ(t, u, v)) {
+    if (prefix(t, u) > prefix(t, v)) { /* v is the parent */
+      j = u;
+      u = v;
+      v = j;
+    }
+    r = cutArc(t, opener(t, v, prefix(t, v)));
+  }
+
+  return r;
+}
+
+int
+ettSwap(ETT t,
+        int u,
+        int v,
+        int id,
+        uint32_t (*uniform)(void*, uint32_t),
+        void* state,
+        int* a,
+        int* b
+        )
+{
+  uint32_t o; /* Arc into the child of the removed edge */
+  int du;
+  int dv;
+  int dl;
+  int k;
+
+  du = prefix(t, u);
+  dv = prefix(t, v);
+  dl = lcaDepth(t, u, v);
+  k = 1 + uniform(state, du + dv - 2*dl);
+
+  if (k <= du - dl) { /* Going up from u */
+    o = opener(t, u, du - k + 1);
+    *a = to(t, o);
+    *b = from(t, o);
+  } else { /* Going down to v */
+    o = opener(t, v, dl + k - (du - dl));
+    *a = from(t, o);
+    *b = to(t, o);
+  }
+  k = cutArc(t, o);
+  ettLink(t, u, v, id);
+
+  return k;
+}
+
+static int
+cutArc(ETT t,
+       uint32_t o
+       )
+{
+  uint32_t q; /* Arc back from the child */
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  int j;
+  int po;
+  int pq;
+
+  q = partner(t, o);
+  po = rank(t, o);
+  pq = rank(t, q);
+
+  split(t, rootOf(t, o), po, &a, &b);
+  split(t, b, 1, &c, &b); /* c is o */
+  split(t, b, pq-po-1, &c, &b); /* c is the tour of the child */
+  split(t, b, 1, &c, &b); /* c is q */
+  merge(t, a, b);
+
+  j = (o - t->V - 1) / 2;
+  ENDS(t)[2*j] = 0;
+  ENDS(t)[2*j+1] = t->free;
+  t->free = j+1;
+
+  return ID(t, o);
+}
+
+int
+ettCycle(ETT t,
+         int u,
+         int v
+         )
+{
+  return prefix(t, u) + prefix(t, v) - 2*lcaDepth(t, u, v) + 1;
+}
+
+void
+ettPathEdge(ETT t,
+            int u,
+            int v,
+            int k,
+            int* a,
+            int* b
+            )
+{
+  int du;
+  int dl;
+  uint32_t o;
+
+  du = prefix(t, u);
+  dl = lcaDepth(t, u, v);
+
+  if (k <= du - dl) { /* Going up from u */
+    o = opener(t, u, du - k + 1);
+    *a = to(t, o);
+    *b = from(t, o);
+  } else { /* Going down to v */
+    o = opener(t, v, dl + k - (du - dl));
+    *a = from(t, o);
+    *b = to(t, o);
+  }
+}
+
+void
+ettDisplay(ETT t,
+           FILE *f
+           )
+{
+  int j;
+  int n;
+
+  n = NODES(t->V) - t->V;
+  j = 0;
+  while (j < n) {
+    if (0 != ENDS(t)[j])
+      fprintf(f, "%d %d\n", ENDS(t)[j], ENDS(t)[j+1]);
+    j += 2;
+  }
+  fprintf(f, "\n");
+}
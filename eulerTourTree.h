@@ -0,0 +1,166 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+/** @file Header file for the Euler Tour Tree ADT.
+
+    The forest is stored as Euler tours, kept in treaps. Arcs going away
+    from the root of a tree count +1 and arcs coming back count -1, so the
+    prefix sum at a vertex is its depth. This gives path queries from the
+    depths. Linking re-roots one of the trees, by rotating its tour, and
+    turns the arcs of the path from its old root to the new one in a
+    single pass over the treap. */
+
+#ifndef EULERTOURTREE_H
+#define EULERTOURTREE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct ETT* ETT; /** Euler tour tree abstract data type. */
+
+/** @return ETT without edges, over vertexes labelled 1 to V */
+ETT
+allocETT(int V /**< [in] Number of vertexes of the underlying graph */
+         );
+
+/** Free the ETT */
+void
+freeETT(ETT t /** [in] */
+        );
+
+/** @return A copy of t. */
+ETT
+cloneETT(ETT t /** [in] */
+         );
+
+/** @return The number of bytes of t. An ETT is one block, holding indexes
+    and no pointers, so these bytes can be written and read back as they
+    are. */
+size_t
+ettBytes(ETT t /** [in] */
+         );
+
+/** @return Number of vertexes in t. */
+int
+ettVertexNr(ETT t /** [in] */
+            );
+
+/** Starts loading the node of v into the cache, without waiting. */
+void
+ettPrefetch(ETT t /**< [in] */,
+            int v /**< [in] Node */
+            );
+
+/** @return The parent of node v in its treap, 0 at the root. The queries
+    on v go up this chain. Reads the node of v. */
+int
+ettAbove(ETT t /**< [in] */,
+         int v /**< [in] Node */
+         );
+
+/** @return 1 if there is a path linking u to v.
+            0 otherwise */
+int
+ettLinkedQ(ETT t /**< [in] */,
+           int u /**< [in] */,
+           int v /**< [in] */
+           );
+
+/** @return 0 if (u,v) is not on the ETT
+            1 otherwise */
+int
+ettEdgeQ(ETT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */
+         );
+
+/** Add the edge (u,v) to the ETT. IMPORTANT: ettLinkedQ(t, u, v) must be
+    false. */
+void
+ettLink(ETT t /**< [in] */,
+        int u /**< [in] */,
+        int v /**< [in] */,
+        int id /**< [in] Edge identifier, returned by ettCut */
+        );
+
+/** Remove the edge (u,v) from the ETT. Does nothing if edge is not there.
+
+    @return The id given to ettLink, -1 if the edge is not there. */
+int
+ettCut(ETT t /**< [in] */,
+       int u /**< [in] */,
+       int v /**< [in] */
+       );
+
+/** IMPORANT: this is only possible if ettLinkedQ(t, u, v) is true.
+
+    @return the number of vertexes on the path from u to v. */
+int
+ettCycle(ETT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */
+         );
+
+/** Obtains the k-th edge on the path from u to v, counting from u. The
+    edge is returned as (*a,*b), with *a closer to u. IMPORTANT: this is only
+    possible if ettLinkedQ(t, u, v) is true. */
+void
+ettPathEdge(ETT t /**< [in] */,
+            int u /**< [in] */,
+            int v /**< [in] */,
+            int k /**< [in] The index of the edge, starting at 1 */,
+            int* a /**< [out] */,
+            int* b /**< [out] */
+            );
+
+/** Replaces one edge of the path from u to v by the edge (u, v), as
+    swapEdge in linkCutTree.h. The removed edge is the k-th one from u,
+    with k drawn as 1 + uniform(path edges), and is found and cut from its
+    arc, without looking it up again.
+    IMPORTANT: u and v must be linked, but not adjacent.
+
+    @return The id of the removed edge. */
+int
+ettSwap(ETT t /**< [in] */,
+        int u /**< [in] */,
+        int v /**< [in] */,
+        int id /**< [in] Identifier of the new edge (u, v) */,
+        uint32_t (*uniform)(void*, uint32_t) /**< [in] Uniform value in
+                                                [0, n[ */,
+        void* state /**< [in/out] First argument of uniform */,
+        int* a /**< [out] Removed edge, endpoint closer to u */,
+        int* b /**< [out] Removed edge */
+        );
+
+/** Prints the edges of the forest, one per line, followed by a blank
+    line. */
+void
+ettDisplay(ETT t /**< [in] */,
+           FILE *f /**< [in] */
+           );
+
+#endif /* EULERTOURTREE_H */
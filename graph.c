@@ -27,12 +27,46 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <bsd/stdlib.h>
+#include <limits.h>
+#include <float.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <strings.h>
 /* #include <stdio.h> */
+#ifdef GRAPH_ZLIB
+#include <zlib.h>
+#endif
 #include "graph.h"
+#include "hugeAlloc.h"
 
 /*** file scope macro definitions *************************/
 
+/* Bitset of vertexes, in 64 bit words. */
+#define BITQ(T, v) ((T)[(v) >> 6] >> ((v) & 63) & 1)
+#define BITSET(T, v) ((T)[(v) >> 6] |= UINT64_C(1) << ((v) & 63))
+
+/* Every byte of a 64 bit word. */
+#define BYTES(c) (UINT64_C(0x0101010101010101) * (c))
+
+/* The high bit of each byte of w that is zero, without carries between
+   the bytes. */
+#define ZEROS(w) (~((((w) & BYTES(0x7f)) + BYTES(0x7f)) | (w) | BYTES(0x7f)))
+
+/* Is c a separator of the numbers on a line of the text of parseEdges. */
+#define SPACEQ(c) (' ' == (c) || '\t' == (c) || '\r' == (c))
+
+/* Smallest text chunk given to a thread of parseEdges. */
+#define CHUNK_MIN (1 << 20)
+
+/* Bytes of the buffers of a reader. */
+#define READ_BLOCK (1 << 20)
+
+/* First bytes of a graph file, the last one is the version. */
+#define GRAPH_MAGIC "USTGRPH1"
+
 /*** file scope typedefs  *********************************/
 
 /*** structure declarations *******************************/
@@ -46,6 +80,108 @@ struct graph
              is d[v+1]/2. */
   int* p; /* Contains indexes to the array E. */
   edge* E; /* Edge array. This array is indexed starting at 0. */
+  int* n; /* Indexed as p, the other endpoint of the edge p[i] of u, for
+             d[u] <= i < d[u+1]. So a walk step reads d[u] and d[u+1], that
+             are together, and n. NULL if a graph file has none. */
+  int* parent; /* Initial tree of a graph file, see graphTree, NULL if */
+  int* id;     /* the file has none. */
+  int* P;
+  void* map; /* Mapping of a graph file, NULL if G was built in memory */
+  size_t bytes; /* Size of the mapping */
+};
+
+/* Arrays of a graph file, in file order. */
+enum { F_E, F_D, F_P, F_N, F_PARENT, F_ID, F_PERM, F_ARRAYS };
+
+/* Header of a graph file. The arrays follow as they are in memory, each
+   at a multiple of GRAPH_ALIGN bytes, so mapping the file gives the graph
+   without parsing. */
+struct graphFile
+{
+  char magic[8]; /* GRAPH_MAGIC, without the terminator */
+  uint32_t intBytes; /* sizeof(int) of the writer */
+  uint32_t arrays; /* F_ARRAYS of the writer */
+  int64_t v; /* Number of vertexes */
+  int64_t e; /* Number of edges */
+  uint64_t off[F_ARRAYS]; /* Offset of each array, 0 if it is absent */
+  uint64_t len[F_ARRAYS]; /* Bytes of each array */
+};
+
+/* One of the walks of WilsonInterleaved. The next load of the walk is
+   prefetched at the end of each turn and used in the following one. */
+struct walker
+{
+  int* A; /* The tree */
+  struct rng* R; /* Its generator */
+  int* C; /* Node color */
+  int* P; /* Permutation for starting */
+  int* Pi; /* Inverse permutation */
+  int i; /* Number of painted nodes */
+  int c; /* Color of the current walk */
+  int u; /* The current vertex */
+  int k; /* Position in p, then in E, of the edge being followed */
+  int v; /* The next vertex */
+  int stage; /* Turn to execute, see WilsonInterleaved */
+};
+
+/* State shared by the threads of sampleTrees. */
+struct pool
+{
+  graph G; /* The graph, only read */
+  void (*sample)(graph, int*, struct rng*); /* The sampler */
+  void (*batch)(graph, int**, struct rng*, int); /* Sampler of K trees,
+                                                    NULL if none */
+  int B; /* Repetitions taken at a time, given to batch */
+  struct rng S; /* Stream of repetition next, jumped once per repetition */
+  long long n; /* Number of repetitions */
+  long long next; /* Next repetition to start */
+  long long written; /* Repetitions already written */
+  int writing; /* 1 while a thread writes, outside the lock */
+  int K; /* Number of slots, started repetitions not yet written */
+  char** text; /* Tree of each slot, NULL until it is done */
+  size_t* len; /* Length of each text */
+  FILE* out; /* Output */
+  pthread_mutex_t lock; /* Guards the fields above */
+  pthread_cond_t room; /* Signalled when written grows */
+};
+
+/* A piece of the text of parseEdges, it starts after a newline and
+   holds whole lines. The numbers are counted in a first pass, where out
+   is NULL, and stored in a second one. */
+struct chunk
+{
+  const char* s; /* First byte */
+  const char* t; /* One past the last byte */
+  size_t n; /* Numbers in the chunk */
+  size_t at; /* Index, in the numbers of E, of the first one */
+  int* out; /* The numbers of E, NULL in the first pass */
+  int v; /* Number of vertexes, the ids stored must be in 1..v */
+  int bad; /* Set on a byte that is not a digit, a separator or a newline,
+              on a line that is not blank and holds other than 2 numbers,
+              or on an id out of range */
+};
+
+/* Text read in blocks, from a file or from the gzip stream in it, for
+   the formats of loadGraphAs that are not parsed by parseEdges. */
+struct reader
+{
+  FILE* f; /* The file */
+  char* b; /* Text buffer */
+  size_t i; /* Next byte of b */
+  size_t n; /* Bytes in b */
+#ifdef GRAPH_ZLIB
+  int gz; /* Is f gzipped */
+  z_stream z; /* Inflates f when gz is 1 */
+  unsigned char* in; /* Bytes read from f, when gz is 1 */
+#endif
+};
+
+/* Edges being read, E grows as needed. */
+struct edgeList
+{
+  edge* E;
+  size_t n; /* Edges in E */
+  size_t cap; /* Room in E */
 };
 
 
@@ -55,6 +191,172 @@ struct graph
 
 /*** file scope functions declarations (static) ***********/
 
+/* @return The neighbour of u at position k of p, d[u] <= k < d[u+1]. */
+static int
+neighbor(graph G /* [in] */,
+         int k /* [in] */,
+         int u /* [in] */
+         );
+
+/* @return The graph in the graph file f, mapped, NULL if f is not a
+   valid graph file. */
+static graph
+mapGraph(FILE* f /* [in] */
+         );
+
+/* Sets the expected length of each array of a graph file of G. */
+static void
+fileLengths(graph G /* [in] */,
+            uint64_t* len /* [out] F_ARRAYS entries */
+            );
+
+/* @return The edges in the text of f, after the vertex and edge counts
+   that go to v and e, NULL if there are less than 2e numbers. The text is
+   mapped, or read in large blocks, and parsed by one thread per chunk. */
+static edge*
+parseEdges(FILE* f /* [in] */,
+           int* v /* [out] */,
+           int* e /* [out] */
+           );
+
+/* @return The first byte in [s, t) that is not a separator, see SPACEQ,
+   or t. */
+static const char*
+skipSpace(const char* s /* [in] */,
+          const char* t /* [in] */
+          );
+
+/* @return The first byte that is not a digit in [s, t), or t. */
+static const char*
+skipDigits(const char* s /* [in] */,
+           const char* t /* [in] */
+           );
+
+/* @return The number written with the digits [s, r), INT_MAX if it is
+   larger. */
+static int
+digitsValue(const char* s /* [in] */,
+            const char* r /* [in] */
+            );
+
+/* Thread body of parseEdges, counts or stores the numbers of a chunk,
+   and orients the edges it stores whole. */
+static void*
+parseWork(void* arg /* [in] struct chunk */
+          );
+
+/* Starts reading f, which is inflated if it starts with the gzip magic.
+
+   @return 0 on success, -1 if f is gzipped and there is no zlib. */
+static int
+rdOpen(struct reader* R /* [out] */,
+       FILE* f /* [in] */
+       );
+
+/* Releases the buffers of R. */
+static void
+rdClose(struct reader* R /* [in] */
+        );
+
+/* @return The next byte of R, without taking it, EOF at the end. */
+static int
+rdPeek(struct reader* R /* [in] */
+       );
+
+/* Takes the bytes of R up to the next newline, included. */
+static void
+rdLine(struct reader* R /* [in] */
+       );
+
+/* Takes a number of R, after blanks, and newlines when line is 0.
+
+   @return 1 if there was one, 0 if the next byte is not a digit. */
+static int
+rdNumber(struct reader* R /* [in] */,
+         long long* x /* [out] */,
+         int line /* [in] Stop at newlines */
+         );
+
+/* Takes the blanks of R, and the newline after them.
+
+   @return 1 if the line, or the text, ended there, 0 otherwise. */
+static int
+rdEnd(struct reader* R /* [in] */
+      );
+
+/* @return The format of the text of R, by its first bytes. */
+static graphFormat
+rdFormat(struct reader* R /* [in] */
+         );
+
+/* Adds the edge (u, w) to L, oriented, unless it is a loop.
+
+   @return 0 on success, -1 if a vertex is too large or there is no
+   memory. */
+static int
+pushEdge(struct edgeList* L /* [in/out] */,
+         long long u /* [in] */,
+         long long w /* [in] */
+         );
+
+/* Reads the formats of loadGraphAs from R. Each returns the edges, and
+   sets v and e, or NULL if the text is not in the format. */
+static edge*
+readText(struct reader* R /* [in] */,
+         int* v /* [out] */,
+         int* e /* [out] */
+         );
+
+static edge*
+readSnap(struct reader* R /* [in] */,
+         int* v /* [out] */,
+         int* e /* [out] */
+         );
+
+static edge*
+readMetis(struct reader* R /* [in] */,
+          int* v /* [out] */,
+          int* e /* [out] */
+          );
+
+static edge*
+readMtx(struct reader* R /* [in] */,
+        int* v /* [out] */,
+        int* e /* [out] */
+        );
+
+/* Sorts the oriented edges E, and drops repeated ones.
+
+   @return E, NULL if there is no memory, in which case E is freed. */
+static edge*
+simpleEdges(edge* E /* [in/out] */,
+            int v /* [in] */,
+            int* e /* [in/out] */
+            );
+
+/* Renumbers the endpoints of the e oriented edges E as 1..v, in the
+   order of the ids, so that files with gaps or ids from 0 give no
+   vertexes without edges.
+
+   @return 0 on success, -1 if there is no memory. */
+static int
+denseIds(edge* E /* [in/out] */,
+         int e /* [in] */,
+         int* v /* [out] */
+         );
+
+/* Compares two ints, for qsort. */
+static int
+intCmp(const void* a /* [in] */,
+       const void* b /* [in] */
+       );
+
+/* Thread body of sampleTrees, takes the next repetition until there are
+   none left. */
+static void*
+sampleWork(void* arg /* [in] struct pool */
+           );
+
 /*** public functions *************************************/
 
 /* Stores a graph with count sort LSD */
@@ -63,20 +365,105 @@ graph
 loadGraph(FILE *f
           )
 {
+  return loadGraphAs(f, GRAPH_AUTO);
+}
+
+graph
+loadGraphAs(FILE* f,
+            graphFormat k
+            )
+{
+  struct reader R;
+  int t;
+  int v;
+  int e;
+  edge* E;
+
+  t = getc(f);
+  ungetc(t, f);
+  if (GRAPH_AUTO == k && GRAPH_MAGIC[0] == t)
+    return mapGraph(f);
+
+  if (0x1f != t /* gzip */
+      && (GRAPH_TEXT == k || (GRAPH_AUTO == k && '#' != t && '%' != t)))
+    E = parseEdges(f, &v, &e);
+  else {
+    E = NULL;
+    if (0 == rdOpen(&R, f)) {
+      if (GRAPH_AUTO == k)
+        k = rdFormat(&R);
+      if (GRAPH_TEXT == k)
+        E = readText(&R, &v, &e);
+      else if (GRAPH_SNAP == k)
+        E = readSnap(&R, &v, &e);
+      else if (GRAPH_METIS == k)
+        E = readMetis(&R, &v, &e);
+      else if (GRAPH_MTX == k)
+        E = readMtx(&R, &v, &e);
+      rdClose(&R);
+    }
+  }
+  if (NULL == E)
+    return NULL;
+
+  return newGraph(v, e, E);
+}
+
+int
+graphFormatOf(const char* s
+              )
+{
+  int r;
+
+  r = -1;
+  if (0 == strcmp("auto", s))
+    r = GRAPH_AUTO;
+  else if (0 == strcmp("text", s))
+    r = GRAPH_TEXT;
+  else if (0 == strcmp("snap", s))
+    r = GRAPH_SNAP;
+  else if (0 == strcmp("metis", s))
+    r = GRAPH_METIS;
+  else if (0 == strcmp("mtx", s))
+    r = GRAPH_MTX;
+
+  return r;
+}
+
+graph
+loadWeightedGraph(FILE *f,
+                  double** W
+                  )
+{
+  graph G;
   int t; /* temporary var for swaps. */
   int i;
   int v;
   int e;
   edge* E;
+  double w;
 
-  fscanf(f, "%d", &v);
-  fscanf(f, "%d", &e);
+  *W = NULL;
+  if (1 != fscanf(f, "%d", &v) || 1 != fscanf(f, "%d", &e)
+      || v < 1 || e < 0)
+    return NULL;
 
   E = (edge*) malloc(e*sizeof(edge));
+  *W = (double*) malloc(e*sizeof(double));
   i = 0;
   while (i < e) {
-    fscanf(f, "%d", &E[i][0]);
-    fscanf(f, "%d", &E[i][1]);
+    /* The weights become resistances 1/w, so each one must be positive
+       and finite. The negated test also rejects NaN. */
+    if (1 != fscanf(f, "%d", &E[i][0]) || 1 != fscanf(f, "%d", &E[i][1])
+        || 1 != fscanf(f, "%lf", &w)
+        || E[i][0] < 1 || v < E[i][0] || E[i][1] < 1 || v < E[i][1]
+        || !(0 < w && w <= DBL_MAX)) {
+      free(E);
+      free(*W);
+      *W = NULL;
+      return NULL;
+    }
+    (*W)[i] = w;
     if(E[i][0] > E[i][1]) {
       t = E[i][0];
       E[i][0] = E[i][1];
@@ -85,7 +472,13 @@ loadGraph(FILE *f
     i++;
   }
 
-  return newGraph(v, e, E);
+  G = newGraph(v, e, E);
+  if (NULL == G) {
+    free(*W);
+    *W = NULL;
+  }
+
+  return G;
 }
 
 graph
@@ -95,24 +488,48 @@ newGraph(int v,
          )
 {
   graph G;
-  int size;
+  size_t size;
   int i;
+  int j;
   int* T; /* temporary array */
   int* O; /* temporary array for orientation */
 
-  size = sizeof(struct graph); /* Struct */
-  size += (v+3)*sizeof(int);   /* Array d */
-  size += 2*e*sizeof(int);     /* Array p */
-  size += e*sizeof(edge);      /* Array E */
-  E = realloc(E, size);
+  size = sizeof(struct graph);      /* Struct */
+  size += (v+3)*sizeof(int);        /* Array d */
+  size += 2*(size_t)e*sizeof(int);  /* Array p */
+  size += (size_t)e*sizeof(edge);   /* Array E */
+  T = (int*) hugeAlloc(size, 1, "graph"); /* Read by every thread */
+  if (NULL == T) {
+    fprintf(stderr, "Error allocating the graph, %zu bytes\n", size);
+    free(E);
+    return NULL;
+  }
+  memcpy(T, E, e*sizeof(edge));
+  free(E);
+  E = (edge*)T;
   G = (graph)&(E[e]); /* Locate the struct at the end of E */
   G->v = v; /* For small structs this value is positive. */
   G->d = (int*)&(G[1]); /* d is at the end of graph struct */
   G->p = &(G->d[v+3]);  /* p is at the end of d */
   G->E = E;
+  G->parent = NULL;
+  G->id = NULL;
+  G->P = NULL;
+  G->map = NULL;
+  G->bytes = 0;
 
-  T = (int*) malloc(2*e*sizeof(int));
-  O = (int*) malloc(2*e*sizeof(int));
+  T = (int*) malloc((2*(size_t)e + 1)*sizeof(int));
+  O = (int*) malloc((2*(size_t)e + 1)*sizeof(int));
+  G->n = (int*) hugeAlloc(2*(size_t)e*sizeof(int), 1, "neighbors");
+  if (NULL == T || NULL == O || NULL == G->n) {
+    fprintf(stderr, "Error allocating the graph, %zu bytes\n",
+            6*(size_t)e*sizeof(int));
+    free(O);
+    free(T);
+    hugeFree(G->n);
+    hugeFree(E);
+    return NULL;
+  }
 
   /* ********** Count Degrees */
   bzero(G->d, (v+3)*sizeof(int));
@@ -155,6 +572,23 @@ newGraph(int v,
   free(O);
   free(T);
 
+  /* ********** Neighbours, in the order of p */
+  i = 0;
+  while (i < 2*e) {
+    G->n[i] = E[G->p[i]][0];
+    i++;
+  }
+  i = 1;
+  while (i <= v) { /* Now the endpoint that is not i */
+    j = G->d[i];
+    while (j < G->d[i+1]) {
+      if (i == G->n[j])
+        G->n[j] = E[G->p[j]][1];
+      j++;
+    }
+    i++;
+  }
+
   return G;
 }
 
@@ -162,7 +596,89 @@ void
 freeGraph(graph G
           )
 {
-  free(G->E);
+  if (NULL != G->map) {
+    munmap(G->map, G->bytes);
+    free(G);
+    return;
+  }
+  if (NULL != G->n)
+    hugeFree(G->n);
+  hugeFree(G->E);
+}
+
+int
+saveGraph(graph G,
+          int* P,
+          int* parent,
+          int* id,
+          FILE* f
+          )
+{
+  struct graphFile h;
+  void* a[F_ARRAYS];
+  uint64_t at; /* Bytes written */
+  int i;
+
+  a[F_E] = G->E;
+  a[F_D] = G->d;
+  a[F_P] = G->p;
+  a[F_N] = G->n;
+  a[F_PARENT] = parent;
+  a[F_ID] = id;
+  a[F_PERM] = P;
+  if (NULL == P || NULL == parent || NULL == id)
+    a[F_PARENT] = a[F_ID] = a[F_PERM] = NULL;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, GRAPH_MAGIC, sizeof(h.magic));
+  h.intBytes = sizeof(int);
+  h.arrays = F_ARRAYS;
+  h.v = G->v;
+  h.e = edgesNr(G);
+  fileLengths(G, h.len);
+  at = GRAPH_ALIGN;
+  i = 0;
+  while (i < F_ARRAYS) {
+    if (NULL != a[i]) {
+      h.off[i] = at;
+      at += (h.len[i] + GRAPH_ALIGN - 1) / GRAPH_ALIGN * GRAPH_ALIGN;
+    }
+    i++;
+  }
+
+  if (1 != fwrite(&h, sizeof(h), 1, f))
+    return -1;
+  at = sizeof(h);
+  i = 0;
+  while (i < F_ARRAYS) {
+    if (NULL != a[i]) {
+      while (at < h.off[i]) { /* Padding */
+        if (EOF == putc(0, f))
+          return -1;
+        at++;
+      }
+      if (1 != fwrite(a[i], h.len[i], 1, f))
+        return -1;
+      at += h.len[i];
+    }
+    i++;
+  }
+
+  return 0 == fflush(f) ? 0 : -1;
+}
+
+int
+graphTree(graph G,
+          int** parent,
+          int** id,
+          int** P
+          )
+{
+  *parent = G->parent;
+  *id = G->id;
+  *P = G->P;
+
+  return NULL != G->parent;
 }
 
 int
@@ -186,6 +702,52 @@ edges(graph G
   return G->E;
 }
 
+int
+graphConnectedQ(graph G
+                )
+{
+  int* Q; /* Queue of the search, also the vertexes seen */
+  char* S; /* Is each vertex seen */
+  int v;
+  int h;
+  int t;
+  int k;
+  int u;
+  int w;
+
+  v = graphVertexNr(G);
+  if (1 > v)
+    return 0;
+  Q = (int*) malloc(v*sizeof(int));
+  S = (char*) calloc(v+1, 1);
+  if (NULL == Q || NULL == S) {
+    free(S);
+    free(Q);
+    return 0;
+  }
+
+  Q[0] = 1;
+  S[1] = 1;
+  h = 0;
+  t = 1;
+  while (h < t) {
+    u = Q[h++];
+    k = G->d[u];
+    while (k < G->d[u+1]) {
+      w = neighbor(G, k, u);
+      if (!S[w]) {
+        S[w] = 1;
+        Q[t++] = w;
+      }
+      k++;
+    }
+  }
+  free(S);
+  free(Q);
+
+  return t == v;
+}
+
 int
 sameE(int au,
       int av,
@@ -263,14 +825,14 @@ printGraph(graph G
 
 void
 randomWalk(graph G,
-           int* A
+           int* A,
+           struct rng* R
            )
 {
   int i; /* Counter and number of visited nodes. */
   int V; /* Number of vertexes in graph. */
   int u; /* The current vertex */
   int v; /* The next vertex */
-  edge* e; /* Edge selected */
   int d; /* Degree of u */
   int j;
 
@@ -282,18 +844,14 @@ randomWalk(graph G,
     i++;
   }
 
-  u = arc4random_uniform(V) + 1;
+  u = rngUniform(R, V) + 1;
   A[u] = 0;
 
   i = 1;
   while(i < V) {
     j = G->d[u];
-    d = arc4random_uniform(G->d[u+1] - G->d[u]);
-    e = &(G->E[G->p[j + d]]);
-
-    v = (*e)[0];
-    if( v == u )
-      v = (*e)[1];
+    d = rngUniform(R, G->d[u+1] - j);
+    v = neighbor(G, j + d, u);
 
     if (-1 == A[v]) { /* Avoid visited nodes */
       A[v] = u;
@@ -323,14 +881,14 @@ swap(int* P,
 
 void
 Wilson(graph G,
-       int* A
+       int* A,
+       struct rng* R
        )
 {
   int i; /* Number of painted nodes */
   int V; /* Number of vertexes */
   int v;
   int u;
-  edge* e;
   int d;
   int j;
   int* C; /* Node color */
@@ -353,7 +911,7 @@ Wilson(graph G,
   }
 
   i = 0;
-  d = arc4random_uniform(V);
+  d = rngUniform(R, V);
   u = P[d];
 
   c = 1;
@@ -365,7 +923,7 @@ Wilson(graph G,
 
   while(i < V) {
     c++;
-    d = arc4random_uniform(V-i);
+    d = rngUniform(R, V-i);
     u = P[d];
     C[u] = c;
     i++;
@@ -374,12 +932,8 @@ Wilson(graph G,
     v = u;
     while (C[v] == c) {
       j = G->d[u];
-      d = arc4random_uniform(G->d[u+1] - G->d[u]);
-      e = &(G->E[G->p[j + d]]);
-
-      v = (*e)[0];
-      if (v == u)
-        v = (*e)[1];
+      d = rngUniform(R, G->d[u+1] - j);
+      v = neighbor(G, j + d, u);
 
       if (C[v] < c) { /* Join */
         A[u] = v;
@@ -406,3 +960,1258 @@ Wilson(graph G,
   if (NULL != C)
     free(C);
 }
+
+void
+WilsonLean(graph G,
+           int* A,
+           struct rng* R
+           )
+{
+  uint64_t* T; /* InTree bits */
+  int V;
+  int i;
+  int u;
+  int v;
+  int j;
+
+  V = graphVertexNr(G);
+  T = (uint64_t*) calloc((V >> 6) + 1, sizeof(uint64_t));
+
+  u = rngUniform(R, V) + 1; /* The root */
+  A[u] = 0;
+  BITSET(T, u);
+
+  i = 1;
+  while (i <= V) {
+    u = i;
+    while (!BITQ(T, u)) { /* Walk, a loop is erased when A[u] is redone */
+      j = G->d[u];
+      v = neighbor(G, j + rngUniform(R, G->d[u+1] - j), u);
+      A[u] = v;
+      u = v;
+    }
+
+    u = i;
+    while (!BITQ(T, u)) { /* Retrace, adding the loop-erased path */
+      BITSET(T, u);
+      u = A[u];
+    }
+    i++;
+  }
+
+  free(T);
+}
+
+void
+WilsonInterleaved(graph G,
+                  int** A,
+                  struct rng* R,
+                  int K
+                  )
+{
+  struct walker* W;
+  struct walker* w;
+  int active; /* Walks not yet done */
+  int V;
+  int k;
+  int d;
+  int j;
+
+  V = graphVertexNr(G);
+  W = (struct walker*) malloc(K*sizeof(struct walker));
+  k = 0;
+  while (k < K) { /* Same start as Wilson */
+    w = &W[k];
+    w->A = A[k];
+    w->R = &R[k];
+    w->C = (int*) calloc(V+1, sizeof(int));
+    w->P = (int*) calloc(V, sizeof(int));
+    w->Pi = (int*) calloc(V+1, sizeof(int));
+    j = 1;
+    while (j <= V) {
+      w->P[j-1] = j;
+      w->Pi[j] = j-1;
+      j++;
+    }
+    d = rngUniform(w->R, V);
+    w->u = w->P[d];
+    w->c = 1;
+    w->A[w->u] = 0;
+    w->C[w->u] = w->c;
+    w->i = 1;
+    swap(w->P, w->Pi, d, V-w->i);
+    w->stage = 0;
+    k++;
+  }
+
+  /* Each walker runs one stage per turn. A stage uses the value that the
+     previous stage of the same walker prefetched, K-1 turns ago. */
+  active = K;
+  while (0 < active) {
+    k = 0;
+    while (k < K) {
+      w = &W[k];
+      if (0 == w->stage) { /* New walk */
+        if (w->i < V) {
+          w->c++;
+          d = rngUniform(w->R, V-w->i);
+          w->u = w->P[d];
+          w->C[w->u] = w->c;
+          w->i++;
+          swap(w->P, w->Pi, d, V-w->i);
+          __builtin_prefetch(&G->d[w->u]);
+          w->stage = 1;
+        } else {
+          w->stage = -1;
+          active--;
+        }
+      } else if (1 == w->stage) { /* Draw the edge to follow */
+        j = G->d[w->u];
+        w->k = j + rngUniform(w->R, G->d[w->u+1] - j);
+        __builtin_prefetch(NULL != G->n ? &G->n[w->k] : &G->p[w->k]);
+        w->stage = 2;
+      } else if (2 == w->stage && NULL == G->n) {
+        w->k = G->p[w->k];
+        __builtin_prefetch(&G->E[w->k]);
+        w->stage = 3;
+      } else if (2 == w->stage || 3 == w->stage) {
+        if (NULL != G->n)
+          w->v = G->n[w->k];
+        else {
+          w->v = G->E[w->k][0];
+          if (w->v == w->u)
+            w->v = G->E[w->k][1];
+        }
+        __builtin_prefetch(&w->C[w->v]);
+        __builtin_prefetch(&w->Pi[w->v]);
+        __builtin_prefetch(&G->d[w->v]);
+        w->stage = 4;
+      } else if (4 == w->stage) { /* The step of Wilson */
+        if (w->C[w->v] < w->c) /* Join */
+          w->A[w->u] = w->v;
+        if (0 == w->C[w->v]) {
+          w->C[w->v] = w->c;
+          w->i++;
+          swap(w->P, w->Pi, w->Pi[w->v], V-w->i);
+          w->u = w->v;
+        } else if (w->C[w->v] == w->c) { /* Loop erasure */
+          while (w->u != w->v) {
+            w->C[w->u] = 0; /* Uncoloring */
+            w->i--;
+            w->u = w->P[V-w->i]; /* Poping from the end of P */
+          }
+        }
+
+        w->stage = 0;
+        if (w->C[w->v] == w->c) { /* The walk goes on from u = v */
+          j = G->d[w->u];
+          w->k = j + rngUniform(w->R, G->d[w->u+1] - j);
+          __builtin_prefetch(NULL != G->n ? &G->n[w->k] : &G->p[w->k]);
+          w->stage = 2;
+        }
+      }
+      k++;
+    }
+  }
+
+  k = 0;
+  while (k < K) {
+    free(W[k].Pi);
+    free(W[k].P);
+    free(W[k].C);
+    k++;
+  }
+  free(W);
+}
+
+static graph
+mapGraph(FILE* f
+         )
+{
+  graph G;
+  struct graphFile* h;
+  struct stat st;
+  void* m;
+  uint64_t len[F_ARRAYS];
+  int ok;
+  int i;
+
+  if (0 != fstat(fileno(f), &st) || (off_t)sizeof(*h) > st.st_size)
+    return NULL;
+  m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+  if (MAP_FAILED == m)
+    return NULL;
+
+  h = (struct graphFile*)m;
+  G = (graph) malloc(sizeof(struct graph));
+  ok = NULL != G
+    && 0 == memcmp(h->magic, GRAPH_MAGIC, sizeof(h->magic))
+    && sizeof(int) == h->intBytes && F_ARRAYS == h->arrays
+    && 0 <= h->v && INT_MAX > h->v && 0 <= h->e && INT_MAX/2 >= h->e
+    && 0 != h->off[F_D] && (h->v+3)*sizeof(int) == h->len[F_D]
+    && (uint64_t)st.st_size >= h->off[F_D] + h->len[F_D];
+
+  if (ok) { /* fileLengths reads v and the number of edges, in d */
+    G->v = h->v;
+    G->d = (int*)((char*)m + h->off[F_D]);
+    ok = 2*h->e == G->d[1+h->v];
+  }
+  if (ok) {
+    fileLengths(G, len);
+    i = 0;
+    while (i < F_ARRAYS) {
+      if (0 != h->off[i])
+        ok = ok && 0 == h->off[i] % GRAPH_ALIGN && len[i] == h->len[i]
+          && (uint64_t)st.st_size >= h->off[i] + len[i];
+      i++;
+    }
+    ok = ok && 0 != h->off[F_E] && 0 != h->off[F_P]
+      && (0 == h->off[F_PARENT]) == (0 == h->off[F_ID])
+      && (0 == h->off[F_PARENT]) == (0 == h->off[F_PERM]);
+  }
+  if (!ok) {
+    free(G);
+    munmap(m, st.st_size);
+    return NULL;
+  }
+
+  G->E = (edge*)((char*)m + h->off[F_E]);
+  G->p = (int*)((char*)m + h->off[F_P]);
+  G->n = NULL;
+  G->parent = NULL;
+  G->id = NULL;
+  G->P = NULL;
+  if (0 != h->off[F_N])
+    G->n = (int*)((char*)m + h->off[F_N]);
+  if (0 != h->off[F_PARENT]) {
+    G->parent = (int*)((char*)m + h->off[F_PARENT]);
+    G->id = (int*)((char*)m + h->off[F_ID]);
+    G->P = (int*)((char*)m + h->off[F_PERM]);
+  }
+  G->map = m;
+  G->bytes = st.st_size;
+
+  return G;
+}
+
+static void
+fileLengths(graph G,
+            uint64_t* len
+            )
+{
+  uint64_t e;
+
+  e = edgesNr(G);
+  len[F_E] = e*sizeof(edge);
+  len[F_D] = (G->v+3)*sizeof(int);
+  len[F_P] = 2*e*sizeof(int);
+  len[F_N] = 2*e*sizeof(int);
+  len[F_PARENT] = (G->v+1)*sizeof(int);
+  len[F_ID] = (G->v+1)*sizeof(int);
+  len[F_PERM] = 2*e*sizeof(int);
+}
+
+static edge*
+parseEdges(FILE* f,
+           int* v,
+           int* e
+           )
+{
+  edge* E;
+  struct stat st;
+  struct chunk* C;
+  pthread_t* th;
+  char* m; /* The text */
+  size_t bytes; /* Its size */
+  size_t mapped; /* Size of the mapping, 0 if m was read */
+  const char* s;
+  const char* t;
+  const char* r;
+  long at;
+  size_t n;
+  int h[2]; /* Header */
+  int T; /* Number of chunks */
+  int ok; /* No bad byte or id so far */
+  int i;
+
+  /* ********** The text, from the position of f */
+  m = NULL;
+  mapped = 0;
+  at = ftell(f);
+  if (0 <= at && 0 == fstat(fileno(f), &st) && S_ISREG(st.st_mode)
+      && at < st.st_size) {
+    m = (char*) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                     fileno(f), 0);
+    if (MAP_FAILED == (void*)m)
+      m = NULL;
+    else {
+      mapped = st.st_size;
+      madvise(m, mapped, MADV_SEQUENTIAL);
+    }
+  }
+  if (NULL != m) {
+    s = m + at;
+    bytes = mapped - at;
+  } else { /* A pipe, read in blocks */
+    n = CHUNK_MIN;
+    bytes = 0;
+    do {
+      n *= 2;
+      s = (const char*) realloc(m, n);
+      if (NULL == s) {
+        free(m);
+        return NULL;
+      }
+      m = (char*)s;
+      bytes += fread(&m[bytes], 1, n - bytes, f);
+    } while (bytes == n);
+  }
+  t = s + bytes;
+
+  /* ********** Header, a line with 2 numbers after any blank lines */
+  while (s < t && (SPACEQ(*s) || '\n' == *s))
+    s++;
+  ok = 1;
+  i = 0;
+  while (i < 2) {
+    s = skipSpace(s, t);
+    r = skipDigits(s, t);
+    ok = ok && s < r;
+    h[i] = digitsValue(s, r);
+    s = r;
+    i++;
+  }
+  s = skipSpace(s, t);
+  ok = ok && (s == t || '\n' == *s); /* A METIS header may have 4 */
+  if (!ok || 1 > h[0] || INT_MAX - 3 <= h[0] || INT_MAX/2 < h[1]) {
+    if (0 != mapped)
+      munmap(m, mapped);
+    else
+      free(m);
+    return NULL;
+  }
+  *v = h[0];
+  *e = h[1];
+
+  /* ********** Chunks, split at newlines */
+  T = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if ((size_t)T > 1 + (t - s)/CHUNK_MIN)
+    T = 1 + (t - s)/CHUNK_MIN;
+  if (1 > T)
+    T = 1;
+  C = (struct chunk*) malloc(T*sizeof(struct chunk));
+  th = (pthread_t*) malloc(T*sizeof(pthread_t));
+  E = (edge*) malloc(*e*sizeof(edge));
+  i = 0;
+  while (i < T) {
+    C[i].s = s;
+    if (i + 1 < T) {
+      s += (t - s)/(T - i);
+      r = (const char*) memchr(s, '\n', t - s);
+      s = NULL == r ? t : r + 1;
+    } else
+      s = t;
+    C[i].t = s;
+    C[i].out = NULL;
+    C[i].v = *v;
+    C[i].bad = 0;
+    i++;
+  }
+
+  /* ********** Count, then store at the place of each chunk */
+  i = 0;
+  while (i < T) {
+    pthread_create(&th[i], NULL, parseWork, &C[i]);
+    i++;
+  }
+  n = 0;
+  i = 0;
+  while (i < T) {
+    pthread_join(th[i], NULL);
+    ok = ok && !C[i].bad;
+    C[i].at = n;
+    C[i].out = (int*)E;
+    n += C[i].n;
+    i++;
+  }
+  /* Exactly the E edges of the header, so lists of other lengths, as a
+     METIS file read as text, fail here */
+  ok = ok && 2*(size_t)*e == n;
+  if (NULL != E && ok) {
+    i = 0;
+    while (i < T) {
+      pthread_create(&th[i], NULL, parseWork, &C[i]);
+      i++;
+    }
+    i = 0;
+    while (i < T) {
+      pthread_join(th[i], NULL);
+      ok = ok && !C[i].bad;
+      i++;
+    }
+  }
+  if (!ok) {
+    free(E);
+    E = NULL;
+  }
+
+  free(th);
+  free(C);
+  if (0 != mapped)
+    munmap(m, mapped);
+  else
+    free(m);
+
+  return E;
+}
+
+static const char*
+skipSpace(const char* s,
+          const char* t
+          )
+{
+  uint64_t w;
+
+  while (s + 8 <= t) {
+    memcpy(&w, s, 8);
+    /* The high bit of each byte of w ends up set for the bytes that are
+       not one of the three separators. */
+    w = ~(ZEROS(w ^ BYTES(' ')) | ZEROS(w ^ BYTES('\t'))
+          | ZEROS(w ^ BYTES('\r'))) & BYTES(0x80);
+    if (0 != w)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return s + __builtin_ctzll(w)/8;
+#else
+      return s + __builtin_clzll(w)/8;
+#endif
+    s += 8;
+  }
+  while (s < t && SPACEQ(*s))
+    s++;
+
+  return s;
+}
+
+static const char*
+skipDigits(const char* s,
+           const char* t
+           )
+{
+  uint64_t w;
+
+  while (s + 8 <= t) {
+    memcpy(&w, s, 8);
+    /* A byte is a digit when it is 0x3? and its low nibble is below
+       10, the high bit of each byte of w ends up set for the others. */
+    w ^= BYTES(0x30);
+    w = (((w & BYTES(0x7f)) + BYTES(0x76)) | w) & BYTES(0x80);
+    if (0 != w)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return s + __builtin_ctzll(w)/8;
+#else
+      return s + __builtin_clzll(w)/8;
+#endif
+    s += 8;
+  }
+  while (s < t && (unsigned)(*s - '0') <= 9)
+    s++;
+
+  return s;
+}
+
+static int
+digitsValue(const char* s,
+            const char* r
+            )
+{
+  long long x;
+
+  x = 0;
+  while (s < r && x < INT_MAX) {
+    x = 10*x + (*s - '0');
+    s++;
+  }
+
+  return s < r || INT_MAX < x ? INT_MAX : x;
+}
+
+static void*
+parseWork(void* arg
+          )
+{
+  struct chunk* c;
+  const char* s;
+  const char* r;
+  int* o;
+  size_t n;
+  size_t i;
+  int k; /* Numbers on the line */
+  int x;
+
+  c = (struct chunk*)arg;
+  s = c->s;
+  if (NULL == c->out) {
+    n = 0;
+    k = 0;
+    while (!c->bad && s < c->t) {
+      s = skipSpace(s, c->t);
+      if (s == c->t)
+        break;
+      if ('\n' == *s) {
+        c->bad = 0 != k && 2 != k;
+        k = 0;
+        s++;
+      } else if ((unsigned)(*s - '0') <= 9) {
+        s = skipDigits(s, c->t);
+        k++;
+        n++;
+      } else
+        c->bad = 1; /* A sign, a point, a comment... */
+    }
+    c->bad = c->bad || (0 != k && 2 != k);
+    c->n = n;
+    return NULL;
+  }
+
+  o = &c->out[c->at];
+  n = 0;
+  while (n < c->n) { /* The bytes were checked by the first pass */
+    while ((unsigned)(*s - '0') > 9)
+      s++;
+    r = skipDigits(s, c->t);
+    x = digitsValue(s, r);
+    if (1 > x || c->v < x) /* newGraph would index out of d */
+      c->bad = 1;
+    o[n] = x;
+    s = r;
+    n++;
+  }
+
+  i = c->at; /* Lines are whole, so are the edges */
+  while (i + 1 < c->at + c->n) {
+    if (c->out[i] > c->out[i+1]) {
+      x = c->out[i];
+      c->out[i] = c->out[i+1];
+      c->out[i+1] = x;
+    }
+    i += 2;
+  }
+
+  return NULL;
+}
+
+static int
+rdOpen(struct reader* R,
+       FILE* f
+       )
+{
+  int t;
+
+  t = getc(f);
+  ungetc(t, f);
+  R->f = f;
+  R->i = 0;
+  R->n = 0;
+#ifdef GRAPH_ZLIB
+  R->gz = 0x1f == t;
+  R->in = NULL;
+  if (R->gz) {
+    memset(&R->z, 0, sizeof(R->z));
+    R->in = (unsigned char*) malloc(READ_BLOCK);
+    if (NULL == R->in)
+      return -1;
+    if (Z_OK != inflateInit2(&R->z, 16 + MAX_WBITS)) { /* gzip header */
+      free(R->in);
+      return -1;
+    }
+  }
+#else
+  if (0x1f == t)
+    return -1;
+#endif
+  R->b = (char*) malloc(READ_BLOCK);
+  if (NULL == R->b) {
+#ifdef GRAPH_ZLIB
+    if (R->gz) {
+      inflateEnd(&R->z);
+      free(R->in);
+    }
+#endif
+    return -1;
+  }
+
+  return 0;
+}
+
+static void
+rdClose(struct reader* R
+        )
+{
+#ifdef GRAPH_ZLIB
+  if (R->gz) {
+    inflateEnd(&R->z);
+    free(R->in);
+  }
+#endif
+  free(R->b);
+}
+
+static int
+rdPeek(struct reader* R
+       )
+{
+#ifdef GRAPH_ZLIB
+  int r;
+#endif
+
+  if (R->i < R->n)
+    return (unsigned char)R->b[R->i];
+
+  R->i = 0;
+  R->n = 0;
+#ifdef GRAPH_ZLIB
+  while (R->gz && 0 == R->n) {
+    if (0 == R->z.avail_in) {
+      R->z.avail_in = fread(R->in, 1, READ_BLOCK, R->f);
+      R->z.next_in = R->in;
+      if (0 == R->z.avail_in)
+        return EOF;
+    }
+    R->z.next_out = (unsigned char*)R->b;
+    R->z.avail_out = READ_BLOCK;
+    r = inflate(&R->z, Z_NO_FLUSH);
+    R->n = READ_BLOCK - R->z.avail_out;
+    if (Z_STREAM_END == r)
+      inflateReset(&R->z); /* The next member, if there is one */
+    else if (Z_OK != r && 0 == R->n)
+      return EOF; /* Corrupt */
+  }
+  if (!R->gz)
+#endif
+    R->n = fread(R->b, 1, READ_BLOCK, R->f);
+  if (0 == R->n)
+    return EOF;
+
+  return (unsigned char)R->b[0];
+}
+
+static void
+rdLine(struct reader* R
+       )
+{
+  char* r;
+
+  while (EOF != rdPeek(R)) {
+    r = (char*) memchr(&R->b[R->i], '\n', R->n - R->i);
+    if (NULL != r) {
+      R->i = r - R->b + 1;
+      return;
+    }
+    R->i = R->n;
+  }
+}
+
+static int
+rdNumber(struct reader* R,
+         long long* x,
+         int line
+         )
+{
+  int c;
+
+  c = rdPeek(R);
+  while (' ' == c || '\t' == c || '\r' == c || (!line && '\n' == c)) {
+    R->i++;
+    c = rdPeek(R);
+  }
+  if ((unsigned)(c - '0') > 9)
+    return 0;
+
+  *x = 0;
+  while ((unsigned)(c - '0') <= 9) {
+    if (*x < INT_MAX) /* Larger ones are rejected by pushEdge */
+      *x = 10 * *x + (c - '0');
+    R->i++;
+    c = rdPeek(R);
+  }
+
+  return 1;
+}
+
+static int
+rdEnd(struct reader* R
+      )
+{
+  int c;
+
+  c = rdPeek(R);
+  while (' ' == c || '\t' == c || '\r' == c) {
+    R->i++;
+    c = rdPeek(R);
+  }
+  if ('\n' == c)
+    R->i++;
+
+  return '\n' == c || EOF == c;
+}
+
+static graphFormat
+rdFormat(struct reader* R
+         )
+{
+  static const char mm[] = "%%MatrixMarket";
+  int c;
+
+  c = rdPeek(R);
+  if ('#' == c)
+    return GRAPH_SNAP;
+  if ('%' != c)
+    return GRAPH_TEXT;
+  if (R->n - R->i >= sizeof(mm) - 1
+      && 0 == memcmp(&R->b[R->i], mm, sizeof(mm) - 1))
+    return GRAPH_MTX;
+
+  return GRAPH_METIS;
+}
+
+static int
+pushEdge(struct edgeList* L,
+         long long u,
+         long long w
+         )
+{
+  edge* E;
+
+  if (INT_MAX <= u || INT_MAX <= w) /* rdNumber stops at INT_MAX */
+    return -1;
+  if (u == w)
+    return 0;
+  if (L->n == L->cap) {
+    L->cap = 0 == L->cap ? 1 << 16 : 2*L->cap;
+    E = (edge*) realloc(L->E, L->cap*sizeof(edge));
+    if (NULL == E)
+      return -1;
+    L->E = E;
+  }
+  L->E[L->n][0] = u < w ? u : w;
+  L->E[L->n][1] = u < w ? w : u;
+  L->n++;
+
+  return 0;
+}
+
+static edge*
+readText(struct reader* R,
+         int* v,
+         int* e
+         )
+{
+  struct edgeList L;
+  long long h[2]; /* Header */
+  long long u;
+  long long w;
+
+  if (!rdNumber(R, &h[0], 0) || !rdNumber(R, &h[1], 1) || !rdEnd(R)
+      || 1 > h[0] || INT_MAX - 3 <= h[0] || INT_MAX/2 < h[1])
+    return NULL;
+
+  L.E = (edge*) malloc((h[1] + 1)*sizeof(edge));
+  L.n = 0;
+  L.cap = h[1] + 1;
+  while (NULL != L.E && L.n < (size_t)h[1]) {
+    if (!rdNumber(R, &u, 0) || !rdNumber(R, &w, 1) || !rdEnd(R) || 1 > u
+        || h[0] < u || 1 > w || h[0] < w) {
+      free(L.E);
+      return NULL;
+    }
+    L.E[L.n][0] = u < w ? u : w; /* As loadGraph, loops are kept */
+    L.E[L.n][1] = u < w ? w : u;
+    L.n++;
+  }
+  if (NULL != L.E && (rdNumber(R, &u, 0) || EOF != rdPeek(R))) {
+    free(L.E); /* More than E edges, or a METIS file */
+    return NULL;
+  }
+  *v = h[0];
+  *e = h[1];
+
+  return L.E;
+}
+
+static edge*
+readSnap(struct reader* R,
+         int* v,
+         int* e
+         )
+{
+  struct edgeList L;
+  long long u;
+  long long w;
+  int c;
+
+  L.E = NULL;
+  L.n = 0;
+  L.cap = 0;
+  while (EOF != (c = rdPeek(R))) {
+    if ('#' != c && '%' != c && rdNumber(R, &u, 1)) {
+      if (!rdNumber(R, &w, 1) || 0 != pushEdge(&L, u, w)) {
+        free(L.E);
+        return NULL;
+      }
+    }
+    rdLine(R); /* Comments, blank lines and other columns */
+  }
+
+  if (INT_MAX/2 < L.n) {
+    free(L.E);
+    return NULL;
+  }
+  if (NULL == L.E) /* No edges */
+    L.E = (edge*) malloc(sizeof(edge));
+  *e = L.n;
+  if (NULL == L.E || 0 != denseIds(L.E, *e, v)) {
+    free(L.E);
+    return NULL;
+  }
+
+  return simpleEdges(L.E, *v, e);
+}
+
+static edge*
+readMetis(struct reader* R,
+          int* v,
+          int* e
+          )
+{
+  struct edgeList L;
+  long long h[4]; /* n, m, fmt and ncon */
+  long long x;
+  long long y;
+  long long u;
+  long long n; /* Entries of the lists */
+  int j;
+  int ok;
+
+  while ('%' == rdPeek(R))
+    rdLine(R);
+  h[2] = 0;
+  h[3] = 1;
+  j = 0;
+  while (j < 4 && rdNumber(R, &h[j], 1))
+    j++;
+  rdLine(R);
+  if (2 > j || INT_MAX - 1 <= h[0] || INT_MAX/2 < h[1])
+    return NULL;
+
+  /* fmt is read as decimal, its digits tell if there are vertex sizes,
+     vertex weights and edge weights */
+  L.E = (edge*) malloc((h[1] + 1)*sizeof(edge));
+  L.n = 0;
+  L.cap = h[1] + 1;
+  ok = NULL != L.E;
+  n = 0;
+  u = 1;
+  while (ok && u <= h[0] && EOF != rdPeek(R)) {
+    if ('%' != rdPeek(R)) {
+      if (1 == h[2] / 100 % 10)
+        ok = rdNumber(R, &x, 1);
+      j = 0;
+      while (ok && 1 == h[2] / 10 % 10 && j < h[3]) {
+        ok = rdNumber(R, &x, 1);
+        j++;
+      }
+      while (ok && rdNumber(R, &x, 1)) {
+        ok = 0 < x && x <= h[0];
+        n++;
+        if (ok && 1 == h[2] % 10) /* Edge weight */
+          ok = rdNumber(R, &y, 1);
+        if (ok && u < x) /* Each edge is in both lists */
+          ok = 0 == pushEdge(&L, u, x);
+      }
+      u++;
+    }
+    rdLine(R);
+  }
+  /* Exactly V lists, after which only comments, that hold each of the E
+     edges twice */
+  ok = ok && h[0] < u && (size_t)h[1] == L.n && 2*h[1] == n;
+  while (ok && EOF != rdPeek(R)) {
+    if ('%' == rdPeek(R))
+      rdLine(R);
+    else
+      ok = !rdNumber(R, &x, 0) && ('%' == rdPeek(R) || EOF == rdPeek(R));
+  }
+  if (!ok) {
+    free(L.E);
+    return NULL;
+  }
+  *v = h[0];
+  *e = L.n;
+
+  return L.E;
+}
+
+static edge*
+readMtx(struct reader* R,
+        int* v,
+        int* e
+        )
+{
+  struct edgeList L;
+  char line[256]; /* Banner */
+  char w[4][64]; /* Its words */
+  long long h[3]; /* Rows, columns and entries */
+  long long i;
+  long long x;
+  long long y;
+  size_t j;
+  int c;
+
+  j = 0;
+  while (EOF != (c = rdPeek(R)) && '\n' != c) {
+    if (j < sizeof(line) - 1)
+      line[j++] = c;
+    R->i++;
+  }
+  line[j] = '\0';
+  if (4 != sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s",
+                  w[0], w[1], w[2], w[3])
+      || 0 != strcasecmp("matrix", w[0])
+      || 0 != strcasecmp("coordinate", w[1])) /* Not dense arrays */
+    return NULL;
+
+  rdLine(R);
+  while ('%' == rdPeek(R) || '\n' == rdPeek(R))
+    rdLine(R);
+  if (!rdNumber(R, &h[0], 1) || !rdNumber(R, &h[1], 1)
+      || !rdNumber(R, &h[2], 1))
+    return NULL;
+  rdLine(R);
+
+  L.E = (edge*) malloc((h[2] + 1)*sizeof(edge));
+  L.n = 0;
+  L.cap = h[2] + 1;
+  i = 0;
+  while (NULL != L.E && i < h[2]) {
+    if (!rdNumber(R, &x, 0) || !rdNumber(R, &y, 0) || 0 == x || 0 == y
+        || 0 != pushEdge(&L, x, y)) {
+      free(L.E);
+      return NULL;
+    }
+    rdLine(R); /* The value, if any */
+    i++;
+  }
+  if (NULL == L.E || INT_MAX/2 < L.n) {
+    free(L.E);
+    return NULL;
+  }
+  *e = L.n;
+  if (0 != denseIds(L.E, *e, v)) { /* Rows and columns without entries */
+    free(L.E);
+    return NULL;
+  }
+
+  return simpleEdges(L.E, *v, e); /* General matrices have both (i,j)
+                                     and (j,i) */
+}
+
+static edge*
+simpleEdges(edge* E,
+            int v,
+            int* e
+            )
+{
+  int* C; /* Ends of the groups of W */
+  int* W; /* Second endpoints, grouped by the first */
+  int i;
+  int j;
+  int k;
+  int u;
+
+  C = (int*) calloc(v+2, sizeof(int));
+  W = (int*) malloc((*e + 1)*sizeof(int));
+  if (NULL == C || NULL == W) {
+    free(W);
+    free(C);
+    free(E);
+    return NULL;
+  }
+
+  i = 0;
+  while (i < *e) {
+    if (E[i][1] > v) { /* Beyond the declared size */
+      free(W);
+      free(C);
+      free(E);
+      return NULL;
+    }
+    C[E[i][0]+1]++;
+    i++;
+  }
+  u = 1;
+  while (u <= v + 1) {
+    C[u] += C[u-1];
+    u++;
+  }
+  i = 0;
+  while (i < *e) {
+    W[C[E[i][0]]++] = E[i][1];
+    i++;
+  }
+
+  k = 0;
+  j = 0;
+  u = 1;
+  while (u <= v) {
+    qsort(&W[j], C[u] - j, sizeof(int), intCmp);
+    i = j;
+    while (i < C[u]) {
+      if (i == j || W[i] != W[i-1]) {
+        E[k][0] = u;
+        E[k][1] = W[i];
+        k++;
+      }
+      i++;
+    }
+    j = C[u];
+    u++;
+  }
+  *e = k;
+  free(W);
+  free(C);
+
+  return E;
+}
+
+static int
+denseIds(edge* E,
+         int e,
+         int* v
+         )
+{
+  int* I; /* The ids, sorted and unique */
+  int* x;
+  int i;
+  int n;
+
+  I = (int*) malloc((2*(size_t)e + 1)*sizeof(int));
+  if (NULL == I)
+    return -1;
+  memcpy(I, E, e*sizeof(edge));
+  qsort(I, 2*(size_t)e, sizeof(int), intCmp);
+  n = 0;
+  i = 0;
+  while (i < 2*e) {
+    if (0 == i || I[i] != I[i-1])
+      I[n++] = I[i];
+    i++;
+  }
+
+  i = 0;
+  while (i < e) { /* The order of the ids is kept, so E stays oriented */
+    x = (int*) bsearch(&E[i][0], I, n, sizeof(int), intCmp);
+    E[i][0] = x - I + 1;
+    x = (int*) bsearch(&E[i][1], I, n, sizeof(int), intCmp);
+    E[i][1] = x - I + 1;
+    i++;
+  }
+  *v = n;
+  free(I);
+
+  return 0;
+}
+
+static int
+intCmp(const void* a,
+       const void* b
+       )
+{
+  int x;
+  int y;
+
+  x = *(const int*)a;
+  y = *(const int*)b;
+
+  return (x > y) - (x < y);
+}
+
+static int
+neighbor(graph G,
+         int k,
+         int u
+         )
+{
+  edge* e;
+  int v;
+
+  if (NULL != G->n)
+    v = G->n[k];
+  else {
+    e = &(G->E[G->p[k]]);
+    v = (*e)[0];
+    if (v == u)
+      v = (*e)[1];
+  }
+
+  return v;
+}
+
+static void*
+sampleWork(void* arg
+           )
+{
+  struct pool* P;
+  struct rng* R; /* A generator per tree */
+  int** A; /* The trees */
+  FILE* f;
+  char** t; /* The trees as text */
+  size_t* l; /* Their lengths */
+  long long i; /* First repetition taken */
+  long long n; /* Repetitions taken */
+  long long b;
+  int V;
+  int j;
+
+  P = (struct pool*) arg;
+  V = graphVertexNr(P->G);
+  A = (int**) malloc(P->B*sizeof(int*));
+  R = (struct rng*) malloc(P->B*sizeof(struct rng));
+  t = (char**) malloc(P->B*sizeof(char*));
+  l = (size_t*) malloc(P->B*sizeof(size_t));
+  b = 0;
+  while (b < P->B) {
+    A[b] = (int*) malloc((V+1)*sizeof(int));
+    b++;
+  }
+
+  pthread_mutex_lock(&P->lock);
+  while (P->next < P->n) {
+    i = P->next;
+    n = MIN(P->B, P->n - i);
+    if (P->written + P->K < i + n) /* Slots full, wait for the writer */
+      pthread_cond_wait(&P->room, &P->lock);
+    else {
+      b = 0;
+      while (b < n) { /* Repetition i + b takes stream i + b */
+        R[b] = P->S;
+        rngJump(&P->S);
+        b++;
+      }
+      P->next += n;
+      pthread_mutex_unlock(&P->lock);
+
+      if (NULL != P->batch)
+        P->batch(P->G, A, R, n);
+      else
+        P->sample(P->G, A[0], &R[0]);
+
+      b = 0;
+      while (b < n) {
+        f = open_memstream(&t[b], &l[b]);
+        j = 1;
+        while (j <= V) {
+          if (0 != A[b][j])
+            fprintf(f, "%d %d\n", j, A[b][j]);
+          j++;
+        }
+        fprintf(f, "\n");
+        fclose(f);
+        b++;
+      }
+
+      pthread_mutex_lock(&P->lock);
+      b = 0;
+      while (b < n) {
+        P->text[(i + b) % P->K] = t[b];
+        P->len[(i + b) % P->K] = l[b];
+        b++;
+      }
+      /* One thread writes the trees that are done, in order, without
+         the lock. Its slot stays taken until written grows. */
+      if (!P->writing) {
+        P->writing = 1;
+        while (P->written < P->n && NULL != P->text[P->written % P->K]) {
+          j = P->written % P->K;
+          b = P->written;
+          pthread_mutex_unlock(&P->lock);
+          printf("%lld\n", b);
+          fwrite(P->text[j], 1, P->len[j], P->out);
+          free(P->text[j]);
+          pthread_mutex_lock(&P->lock);
+          P->text[j] = NULL;
+          P->written++;
+          pthread_cond_broadcast(&P->room);
+        }
+        P->writing = 0;
+      }
+    }
+  }
+  pthread_mutex_unlock(&P->lock);
+
+  b = 0;
+  while (b < P->B) {
+    free(A[b]);
+    b++;
+  }
+  free(l);
+  free(t);
+  free(R);
+  free(A);
+
+  return NULL;
+}
+
+void
+sampleTrees(graph G,
+            void (*sample)(graph, int*, struct rng*),
+            void (*batch)(graph, int**, struct rng*, int),
+            int B,
+            uint64_t seed,
+            long long n,
+            int T,
+            FILE* out
+            )
+{
+  struct pool P;
+  pthread_t* th;
+  int i;
+
+  if (T < 1)
+    T = 1;
+  if (NULL == batch || B < 1)
+    B = 1;
+  P.G = G;
+  P.sample = sample;
+  P.batch = batch;
+  P.B = B;
+  rngSeed(&P.S, seed);
+  P.n = n;
+  P.next = 0;
+  P.written = 0;
+  P.writing = 0;
+  P.K = 4*T*B;
+  P.text = (char**) calloc(P.K, sizeof(char*));
+  P.len = (size_t*) calloc(P.K, sizeof(size_t));
+  P.out = out;
+  pthread_mutex_init(&P.lock, NULL);
+  pthread_cond_init(&P.room, NULL);
+
+  th = (pthread_t*) malloc(T*sizeof(pthread_t));
+  i = 1;
+  while (i < T) {
+    pthread_create(&th[i], NULL, sampleWork, &P);
+    i++;
+  }
+  sampleWork(&P);
+  i = 1;
+  while (i < T) {
+    pthread_join(th[i], NULL);
+    i++;
+  }
+
+  pthread_cond_destroy(&P.room);
+  pthread_mutex_destroy(&P.lock);
+  free(th);
+  free(P.len);
+  free(P.text);
+}
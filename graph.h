@@ -30,7 +30,8 @@
  * @date   Wed May  8 09:55:20 2013
  *
  * @brief A definition of a graph ADT, but not very abstract. The graphs
- * are undirected and unweighted. The vertexes are numbered 1 to V.
+ * are undirected and unweighted, edge weights are kept apart, in arrays
+ * indexed as the edges. The vertexes are numbered 1 to V.
  *
  */
 
@@ -38,6 +39,7 @@
 #define GRAPH_H
 
 #include <stdio.h>
+#include "rng.h"
 
 /* #warning "TODO: Mark with this." */
 
@@ -46,18 +48,90 @@
 typedef struct graph* graph; /* Graph ADT. */
 typedef int edge[2]; /* An edge is simply a pair of integers. */
 
+/* Alignment of the arrays of a graph file, a page. */
+#define GRAPH_ALIGN 4096
+
 /*** enums ************************************************/
 
+typedef enum {
+  GRAPH_AUTO, /** Told by the first bytes, the default */
+  GRAPH_TEXT, /** "V E" and the edges, described in the README */
+  GRAPH_SNAP, /** Edge list, # comments, any ids, renumbered 1 to V */
+  GRAPH_METIS, /** Adjacency lists, % comments */
+  GRAPH_MTX /** Matrix Market coordinate file */
+} graphFormat;
+
 /*** structures declarations (only if really necessary) ***/
 
 /*** declarations of public functions (first inlines) *****/
 
-/** @return Reads a graph from a file. */
+/** @return Reads a graph from a file. The file is either text, as
+    described in the README, which is parsed by one thread per core, or a
+    graph file written by saveGraph, which is mapped as it is, read only,
+    with no parsing. NULL if the text does not hold exactly E lines of 2
+    numbers after the header, holds a byte that is not a digit or a space,
+    or an id out of 1..V, if a graph file can not be mapped, or was
+    written by another kind of machine. */
 graph
 loadGraph(FILE *f /** [in] load graph from file. */
           );
 
-/** @return A graph structure from an edge array. */
+/** @return Reads a graph in format k from a file, which may be gzipped
+    when the library is built with GRAPH_ZLIB. The SNAP and Matrix Market
+    readers infer V and E, and drop loops and repeated edges. With
+    GRAPH_AUTO a file starting with # is read as SNAP, one starting with
+    %%MatrixMarket as Matrix Market, one starting with % as METIS, and
+    others as in loadGraph. NULL if the file is not in the format, or
+    its header does not match the lines that follow. A METIS file without
+    comments fails as text, unless every vertex has 2 neighbours, so it
+    should be given as GRAPH_METIS. */
+graph
+loadGraphAs(FILE* f /** [in] */,
+            graphFormat k /** [in] */
+            );
+
+/** @return The format of name s, -1 if there is none. */
+int
+graphFormatOf(const char* s /** [in] "auto", "text", "snap", "metis" or
+                                "mtx" */
+              );
+
+/** Writes G as a graph file, see loadGraph. The file holds the arrays of
+    G, and the initial tree of loadForest when P, parent and id are not
+    NULL, see initialTree in mixer.h. It is only meant for machines with
+    the same int size and byte order.
+
+    @return 0 on success, -1 on errors. */
+int
+saveGraph(graph G /** [in] */,
+          int* P /** [in] 2*edgesNr(G) entries, or NULL */,
+          int* parent /** [in] V+1 entries, or NULL */,
+          int* id /** [in] V+1 entries, or NULL */,
+          FILE* f /** [in] Opened for writing */
+          );
+
+/** Gets the initial tree stored in the graph file of G. The arrays are
+    read only, and live until G is freed.
+
+    @return 1 if G has one, 0 otherwise. */
+int
+graphTree(graph G /** [in] */,
+          int** parent /** [out] */,
+          int** id /** [out] */,
+          int** P /** [out] */
+          );
+
+/** @return Reads a graph from a file, where each edge is followed by its
+    weight, or NULL when the file can not be read, an id is outside 1..v
+    or a weight is not positive and finite. */
+graph
+loadWeightedGraph(FILE *f /** [in] load graph from file. */,
+                  double** W /** [out] Weights indexed as the edges, must
+                                 be freed. */
+                  );
+
+/** @return A graph structure from an edge array, or NULL, after a
+    message on stderr, if there is no memory for it. E is freed then. */
 graph
 newGraph(int v /** [in] number of vertexes */,
          int e /** [in] number of edges */,
@@ -84,6 +158,14 @@ edge *
 edges(graph G /** [in] */
       );
 
+/** @return 1 if G has a vertex and is connected, so that it has spanning
+    trees, 0 if it has isolated vertexes or more than one component. The
+    samplers loop or overflow their arrays on such graphs, so they are
+    rejected after loading. */
+int
+graphConnectedQ(graph G /** [in] */
+                );
+
 /** @return True if the two edges are equal. */
 int
 sameE(int au /** [in] */,
@@ -108,14 +190,62 @@ printGraph(graph G /**< [in] The graph */
 void
 randomWalk(graph G /** [in] The graph to walk over */,
            int* A /** [out] Vertex indexed array to store the tree, needs
-		      to be pre-alloced. */
+		      to be pre-alloced. */,
+           struct rng* R /** [in/out] */
            );
 
 /** Executes Wilson's algorithm */
 void
 Wilson(graph G /** [in] */,
        int* A /** [out] Vertex indexed array to store the tree, needs to be
-		  pre-alloced. */
+		  pre-alloced. */,
+       struct rng* R /** [in/out] */
        );
 
+/** Executes Wilson's algorithm as first stated, with one InTree bit per
+    vertex besides A. The walks store their last exit of each vertex in A,
+    which erases the loops, and are then retraced into the tree. Needs
+    about a quarter of the memory of Wilson, and does fewer writes per
+    step, but draws differently, so the trees differ from those of Wilson
+    with the same generator. */
+void
+WilsonLean(graph G /** [in] */,
+           int* A /** [out] Vertex indexed array to store the tree, needs
+                      to be pre-alloced. */,
+           struct rng* R /** [in/out] */
+           );
+
+/** Executes Wilson's algorithm K times, in lock-step. The walks take
+    turns, each turn does one of the dependent loads of a walk step and
+    prefetches the next, so the cache misses of one walk overlap with the
+    work of the others. Tree k is the one Wilson(G, A[k], &R[k]) gives. */
+void
+WilsonInterleaved(graph G /** [in] */,
+                  int** A /** [out] K vertex indexed arrays, as in
+                              Wilson */,
+                  struct rng* R /** [in/out] K generators */,
+                  int K /** [in] */
+                  );
+
+/** Writes n trees of G, drawn by sample, to out, in the format of the
+    binaries. The repetitions are handed to T threads as they become
+    free, so slow trees do not leave threads idle. When batch is not NULL
+    each thread takes B repetitions at a time and draws them with one call
+    to batch. Repetition i draws from the generator seeded with seed and
+    jumped i times, see rngJump, and the trees are written in repetition
+    order, so out depends on neither T nor B. */
+void
+sampleTrees(graph G /** [in] */,
+            void (*sample)(graph, int*, struct rng*) /** [in] randomWalk
+                                                        or Wilson */,
+            void (*batch)(graph, int**, struct rng*, int) /** [in]
+                                                  WilsonInterleaved, NULL if
+                                                  there is none */,
+            int B /** [in] Trees per call to batch */,
+            uint64_t seed /** [in] */,
+            long long n /** [in] Number of trees */,
+            int T /** [in] Number of threads */,
+            FILE* out /** [in] */
+            );
+
 #endif /* GRAPH_H */
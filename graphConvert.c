@@ -0,0 +1,159 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "graph.h"
+#include "mixer.h"
+
+#define STR_(X) #X
+#define STR(X) STR_(X)
+
+int
+main(int argc, char **argv)
+{
+  int tree = 0; /* Store the initial tree */
+  int bad = 0; /* Unknown option */
+  int format = GRAPH_AUTO; /* Format of <input>, see graph.h */
+  int opt;
+
+  while(-1 != (opt = getopt(argc, argv, "tF:"))){
+    if('t' == opt)
+      tree = 1;
+    else if('F' == opt)
+      format = graphFormatOf(optarg);
+    else
+      bad = 1;
+  }
+  argc -= optind-1;
+  argv += optind-1;
+
+  if(3 != argc || bad || -1 == format){
+    printf("SYNOPSIS\n");
+    printf("\n");
+    printf("./graphConvert [-t] [-F auto|text|snap|metis|mtx] <input> <output>\n");
+    printf("\n");
+    printf("DESCRIPTION\n");
+    printf("\n");
+    printf("Converts the graph in the <input> file into a graph file, written\n");
+    printf("to <output>. A graph file holds the arrays of the graph as they are\n");
+    printf("in memory, so the other binaries map it instead of parsing it, and\n");
+    printf("start in about the time it takes to read it. It is only meant for\n");
+    printf("machines with the same int size and byte order.\n");
+    printf("\n");
+    printf("The -t option also stores the initial spanning tree of edgeSwap,\n");
+    printf("which then builds its tree from the file instead of computing it.\n");
+    printf("\n");
+    printf("The -F option reads <input> as text, SNAP edge lists, METIS\n");
+    printf("adjacency lists or Matrix Market files, which may be gzipped. By\n");
+    printf("default the format is told by the first bytes of the file, so -F is\n");
+    printf("only needed for METIS files without comment lines, which are\n");
+    printf("otherwise rejected as text.\n");
+    printf("\n");
+  } else {
+    printf("BSD 2-Clause License\n");
+    printf("\n");
+    printf("Copyright (c) 2020, Luís M. S. Russo\n");
+    printf("All rights reserved.\n");
+    printf("\n");
+    printf("Redistribution and use in source and binary forms, with or without\n");
+    printf("modification, are permitted provided that the following conditions are met:\n");
+    printf("\n");
+    printf("1. Redistributions of source code must retain the above copyright notice, this\n");
+    printf("   list of conditions and the following disclaimer.\n");
+    printf("\n");
+    printf("2. Redistributions in binary form must reproduce the above copyright notice,\n");
+    printf("   this list of conditions and the following disclaimer in the documentation\n");
+    printf("   and/or other materials provided with the distribution.\n");
+    printf("\n");
+    printf("THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS \"AS IS\"\n");
+    printf("AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE\n");
+    printf("IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE\n");
+    printf("DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE\n");
+    printf("FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL\n");
+    printf("DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR\n");
+    printf("SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER\n");
+    printf("CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,\n");
+    printf("OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE\n");
+    printf("OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.\n");
+    printf("\n");
+    printf("Graph converter, version %s\n", STR(_LIBUSTREE_VERSION) );
+    printf("\n");
+    printf("\n");
+
+    char *fileName = argv[1];
+    FILE *fin = fopen(fileName, "r");
+    fileName = argv[2];
+    FILE *fout = fopen(fileName, "w");
+    if(NULL != fin){
+      if(NULL != fout){
+	graph G = loadGraphAs(fin, format);
+	fclose(fin);
+	if(NULL != G && tree && !graphConnectedQ(G)){
+	  fclose(fout);
+	  freeGraph(G);
+	  printf("Error: the graph is not connected, or has isolated vertexes\n");
+	} else if(NULL != G){
+	  int V = graphVertexNr(G);
+	  int *P = NULL;
+	  int *parent = NULL;
+	  int *id = NULL;
+	  int r = -2; /* Result of saveGraph, -2 if it was not called */
+
+	  if(tree){
+	    P = (int *)malloc(2*edgesNr(G)*sizeof(int));
+	    parent = (int *)malloc((V+1)*sizeof(int));
+	    id = (int *)malloc((V+1)*sizeof(int));
+	    if(NULL != P && NULL != parent && NULL != id)
+	      initialTree(G, P, parent, id);
+	  }
+	  if(!tree || (NULL != P && NULL != parent && NULL != id))
+	    r = saveGraph(G, P, parent, id, fout);
+	  if(0 != fclose(fout) && 0 == r)
+	    r = -1;
+	  if(-2 == r)
+	    printf("Error allocating the tree\n");
+	  else if(-1 == r)
+	    printf("Error writing output file\n");
+	  else
+	    printf("All Ok. %d vertexes and %d edges.\n", V, edgesNr(G));
+	  free(id);
+	  free(parent);
+	  free(P);
+	  freeGraph(G);
+	} else {
+	  fclose(fout);
+	  printf("Error reading input file\n");
+	}
+      } else
+	printf("Error opening output file\n");
+    } else
+      printf("Error opening input file\n");
+  }
+}
@@ -0,0 +1,336 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Implementation of the allocation of the large arrays. */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif /* __linux__ */
+
+#include "hugeAlloc.h"
+
+/*** file scope macro definitions *************************/
+
+/* Bytes before each block, keeps it 64 byte aligned. */
+#define HEAD 64
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif /* MAP_HUGE_SHIFT */
+
+/* Memory policy of mbind, from linux/mempolicy.h. */
+#define MPOL_INTERLEAVE 3
+
+/* Longest node list that is read. */
+#define NODES 1024
+
+/*** structure declarations *******************************/
+
+struct head { /** Stored in the HEAD bytes before each block. */
+  size_t size; /** Asked bytes */
+  size_t bytes; /** Mapped bytes, head included, 0 for malloc */
+  int asked; /** Pages asked, a hugeKind */
+  int kind; /** Pages mapped, a hugeKind */
+  int nodes; /** NUMA nodes it is interleaved over, 0 if none */
+  const char* name; /** Given to hugeAlloc */
+  struct head* prev; /** Live blocks, in the order they were allocated */
+  struct head* next;
+};
+
+/*** file scope variables (static) ************************/
+
+static hugeKind pages = HUGE_NONE; /* Set by hugeSetup */
+static int interleaved = 0; /* Set by hugeSetup */
+static struct head live = {0, 0, 0, 0, 0, NULL, &live, &live}; /* Ends the
+                                      circular list of live blocks, which
+                                      hugeReport prints */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER; /* Of live */
+
+/*** file scope functions declarations (static) ***********/
+
+/** @return Mapping of n bytes with pages of kind k, NULL on failure.
+    HUGE_NONE maps plain pages. */
+static void*
+mapPages(size_t n /**< [in] Multiple of the page size */,
+         hugeKind k /**< [in] */
+         );
+
+/** Interleaves the n bytes at p over the online NUMA nodes.
+
+    @return The number of nodes, 0 if it was not done. */
+static int
+interleave(void* p /**< [in] */,
+           size_t n /**< [in] */
+           );
+
+/** Adds h to the live blocks, or removes it. The list has no bound, so
+    hugeReport sees every block, however many -j makes. */
+static void
+track(struct head* h /**< [in] */,
+      int add /**< [in] */
+      );
+
+/*** implementation ***************************************/
+
+static void*
+mapPages(size_t n,
+         hugeKind k
+         )
+{
+  void* p;
+  int flags;
+
+  flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+  if (HUGE_2M == k)
+    flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+  if (HUGE_1G == k)
+    flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+#else
+  if (HUGE_2M == k || HUGE_1G == k)
+    return NULL;
+#endif /* MAP_HUGETLB */
+
+  p = mmap(NULL, n, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (MAP_FAILED == p)
+    return NULL;
+#ifdef MADV_HUGEPAGE
+  if (HUGE_THP == k)
+    madvise(p, n, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+
+  return p;
+}
+
+static int
+interleave(void* p,
+           size_t n
+           )
+{
+  int r;
+#ifdef __linux__
+  unsigned long mask[NODES/(8*sizeof(unsigned long))];
+  FILE* f;
+  int a;
+  int b;
+  char c;
+
+  r = 0;
+  memset(mask, 0, sizeof(mask));
+  f = fopen("/sys/devices/system/node/online", "r");
+  if (NULL != f) {
+    c = ',';
+    while (',' == c && 1 == fscanf(f, "%d", &a)) { /* As in 0-3,5 */
+      b = a;
+      c = fgetc(f);
+      if ('-' == c && 1 == fscanf(f, "%d", &b))
+        c = fgetc(f);
+      while (a <= b && a < NODES) {
+        mask[a/(8*sizeof(unsigned long))] |= 1UL << a%(8*sizeof(unsigned long));
+        r++;
+        a++;
+      }
+    }
+    fclose(f);
+  }
+  if (1 < r && 0 != syscall(SYS_mbind, p, n, MPOL_INTERLEAVE, mask,
+                            (unsigned long)NODES, 0))
+    r = 0;
+  if (1 == r)
+    r = 0;
+#else
+  r = 0;
+#endif /* __linux__ */
+
+  return r;
+}
+
+static void
+track(struct head* h,
+      int add
+      )
+{
+  pthread_mutex_lock(&lock);
+  if (add) {
+    h->prev = live.prev;
+    h->next = &live;
+    live.prev->next = h;
+    live.prev = h;
+  } else {
+    h->prev->next = h->next;
+    h->next->prev = h->prev;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+/* End of Static Functions */
+
+int
+hugeKindOf(const char* s
+           )
+{
+  int r;
+
+  r = -1;
+  if (0 == strcmp("none", s))
+    r = HUGE_NONE;
+  else if (0 == strcmp("thp", s))
+    r = HUGE_THP;
+  else if (0 == strcmp("2M", s))
+    r = HUGE_2M;
+  else if (0 == strcmp("1G", s))
+    r = HUGE_1G;
+
+  return r;
+}
+
+void
+hugeSetup(hugeKind k,
+          int interleave
+          )
+{
+  pages = k;
+  interleaved = interleave;
+}
+
+void*
+hugeAlloc(size_t n,
+          int shared,
+          const char* name
+          )
+{
+  struct head* h;
+  size_t b;
+  size_t s; /* Page size */
+  int k;
+
+  h = NULL;
+  b = 0;
+  k = pages;
+  if (HUGE_NONE != pages || (shared && interleaved)) { /* mbind needs a
+                                                          mapping */
+    while (NULL == h && HUGE_NONE <= k) { /* Falls back to smaller pages */
+      s = HUGE_1G == k ? 1UL << 30 : HUGE_2M == k ? 1UL << 21 :
+        (size_t)sysconf(_SC_PAGESIZE);
+      b = (n + HEAD + s - 1) / s * s;
+      h = (struct head*) mapPages(b, k);
+      k--;
+    }
+    k++;
+  }
+
+  if (NULL != h) {
+    h->bytes = b;
+    h->nodes = shared && interleaved ? interleave(h, b) : 0;
+  } else {
+    k = HUGE_NONE;
+    if (0 != posix_memalign((void**)&h, HEAD, n + HEAD))
+      return NULL;
+    h->bytes = 0;
+    h->nodes = 0;
+  }
+  h->size = n;
+  h->asked = pages;
+  h->kind = k;
+  h->name = name;
+  track(h, 1);
+
+  return (char*)h + HEAD;
+}
+
+void
+hugeFree(void* p
+         )
+{
+  struct head* h;
+
+  if (NULL != p) {
+    h = (struct head*)((char*)p - HEAD);
+    track(h, 0);
+    if (0 == h->bytes)
+      free(h);
+    else
+      munmap(h, h->bytes);
+  }
+}
+
+void
+hugeReport(FILE* f
+           )
+{
+  static const char* kinds[] = {"plain pages", "transparent huge pages",
+                                "2 MB pages", "1 GB pages"};
+  FILE* s;
+  char line[256];
+  unsigned long a;
+  unsigned long b;
+  unsigned long kps; /* KernelPageSize, in kB */
+  unsigned long thp; /* AnonHugePages, in kB */
+  unsigned long rss; /* Rss, in kB */
+  struct head* h;
+  int in; /* 1 while reading the mapping of a block */
+
+  pthread_mutex_lock(&lock);
+  h = live.next;
+  while (&live != h) {
+    fprintf(f, "%s: %.1f MB, asked %s", h->name,
+            h->size / (1024.0*1024.0), kinds[h->asked]);
+    if (0 == h->bytes)
+      fprintf(f, ", from malloc");
+    else if (h->asked != h->kind)
+      fprintf(f, ", fell back to %s", kinds[h->kind]);
+    if (0 < h->nodes)
+      fprintf(f, ", interleaved over %d nodes", h->nodes);
+    kps = 0;
+    thp = 0;
+    rss = 0;
+    in = 0;
+    s = 0 != h->bytes ? fopen("/proc/self/smaps", "r") : NULL;
+    while (NULL != s && NULL != fgets(line, sizeof(line), s)) {
+      if (2 == sscanf(line, "%lx-%lx ", &a, &b)) /* A new mapping */
+        in = a <= (uintptr_t)h && (uintptr_t)h < b;
+      else if (in) {
+        sscanf(line, "KernelPageSize: %lu kB", &kps);
+        sscanf(line, "AnonHugePages: %lu kB", &thp);
+        sscanf(line, "Rss: %lu kB", &rss);
+      }
+    }
+    if (NULL != s) {
+      fclose(s);
+      fprintf(f, ", got %lu kB pages", kps);
+      if (HUGE_THP == h->kind)
+        fprintf(f, ", %lu of %lu kB resident in huge pages", thp, rss);
+    }
+    fprintf(f, "\n");
+    h = h->next;
+  }
+  pthread_mutex_unlock(&lock);
+}
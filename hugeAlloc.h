@@ -0,0 +1,86 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Header for the allocation of the large arrays.
+
+    The graph and the dynamic forests are each one block. On large graphs
+    random accesses to them miss the TLB on almost every step, and on
+    machines with several sockets the threads that share the graph reach
+    most of it on a remote node. hugeAlloc maps those blocks with huge
+    pages, and can interleave the shared ones over the NUMA nodes. The
+    default keeps malloc. */
+
+#ifndef HUGEALLOC_H
+#define HUGEALLOC_H
+
+#include <stdio.h>
+
+/*** enums ************************************************/
+
+typedef enum {
+  HUGE_NONE, /** malloc, the default */
+  HUGE_THP, /** Transparent huge pages, asked with madvise */
+  HUGE_2M, /** 2 MB pages, reserved in the hugetlb pool */
+  HUGE_1G /** 1 GB pages, reserved in the hugetlb pool */
+} hugeKind;
+
+/*** declarations of public functions (first inlines) *****/
+
+/** @return The kind of name s, -1 if there is none. */
+int
+hugeKindOf(const char* s /**< [in] "none", "thp", "2M" or "1G" */
+           );
+
+/** Chooses the pages of the next allocations. Shared blocks are
+    interleaved over the NUMA nodes when interleave is 1. Call before the
+    allocations, and before starting threads. */
+void
+hugeSetup(hugeKind k /**< [in] */,
+          int interleave /**< [in] */
+          );
+
+/** @return A block of n bytes, 64 byte aligned, that must be released
+    with hugeFree. When the pages asked in hugeSetup are not available it
+    falls back one size at a time, from 1G to 2M pages, then to
+    transparent huge pages and then to plain pages. */
+void*
+hugeAlloc(size_t n /**< [in] */,
+          int shared /**< [in] 1 if read by several threads */,
+          const char* name /**< [in] Used by hugeReport, kept as is */
+          );
+
+/** Releases a block of hugeAlloc. */
+void
+hugeFree(void* p /**< [in] */
+         );
+
+/** Prints the page sizes that each live block actually got, from
+    /proc/self/smaps. */
+void
+hugeReport(FILE* f /**< [in] */
+           );
+
+#endif /* HUGEALLOC_H */
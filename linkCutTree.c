@@ -32,74 +32,264 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
 
 #include "linkCutTree.h"
+#include "hugeAlloc.h"
 
 /*** file scope macro definitions *************************/
 
+/* Node fields are accessed by index. Index 0 is the NULL node, its sum is
+   kept at 0 so that sizeAux needs no test. Compile with -D LCT_SOA to store
+   each field in its own array, instead of an array of nodes.
+
+   Nodes 1 to V are the vertexes, nodes V+1 to 2V-1 represent the edges, so
+   a path alternates between vertexes and edges. NODES(t) counts them all,
+   including the NULL node. */
+#define NODES(t) (2*(t)->V)
+
+#ifdef LCT_SOA
+#define FIELD(t, f, v) (((uint32_t*)&(t)[1])[(f)*NODES(t)+(v)])
+#define LEFT(t, v) FIELD(t, 0, v)
+#define RIGHT(t, v) FIELD(t, 1, v)
+#define PARENT(t, v) FIELD(t, 2, v)
+#define SUM(t, v) (*(int32_t*)&FIELD(t, 3, v))
+#define AGG(t, v) (((struct agg*)&FIELD(t, 4, 0))[v])
+#else
+#define NODE(t, v) (((struct node*)&(t)[1])[v])
+#define LEFT(t, v) (NODE(t, v).left)
+#define RIGHT(t, v) (NODE(t, v).right)
+#define PARENT(t, v) (NODE(t, v).parent)
+#define SUM(t, v) (NODE(t, v).sum)
+#define AGG(t, v) (NODE(t, v).agg)
+#endif /* LCT_SOA */
+
+/* Balancing strategy of the aux trees, chosen with -D LCT_AUX=<name>.
+
+   LCT_SPLAY   Bottom-up splaying, the default.
+   LCT_TOPDOWN Top-down splaying, over the path recorded bottom-up.
+   LCT_SEMI    Semi-splaying, the node only moves half way up.
+   LCT_TREAP   Treap, with priorities hashed from the node index.
+
+   The first two bring the node to the root of its aux tree, the others
+   work by walking up from the node and split/join. */
+#define LCT_SPLAY 0
+#define LCT_TOPDOWN 1
+#define LCT_SEMI 2
+#define LCT_TREAP 3
+
+#ifndef LCT_AUX
+#define LCT_AUX LCT_SPLAY
+#endif /* LCT_AUX */
+
+/* Compile with -D LCT_ROOTED to keep each tree rooted at a fixed vertex.
+   Paths are then found through the lowest common ancestor, so there are no
+   lazy flips on the way. The re-rooting that link still needs reverses the
+   path eagerly, the cost is linear in its size. */
+#ifdef LCT_ROOTED
+#define LCT_EAGER 1
+#else
+#define LCT_EAGER 0
+#endif /* LCT_ROOTED */
+
+/* Path aggregate kept besides the sizes, chosen with -D LCT_AGG=<name>.
+
+   LCT_AGG_SIZE   Sizes only, the default. Every edge weighs 1.
+   LCT_AGG_SUM    Weight of the node and sum over the sub-tree.
+   LCT_AGG_MINMAX Weight of the node and minimum and maximum over the
+                  sub-tree.
+
+   Vertexes weigh the neutral value, only edge nodes carry weights. For
+   LCT_AGG_MINMAX that is NAN, which minW and maxW skip as their first
+   argument, the NULL node has an empty range. PULL
+   recomputes the aggregate of a node from its children, it is called
+   wherever the sizes change and is empty for LCT_AGG_SIZE, so that build
+   has the same nodes and code as without aggregates. Reversing a path
+   does not change any of them. */
+#define LCT_AGG_SIZE 0
+#define LCT_AGG_SUM 1
+#define LCT_AGG_MINMAX 2
+
+#ifndef LCT_AGG
+#define LCT_AGG LCT_AGG_SIZE
+#endif /* LCT_AGG */
+
+#if LCT_AGG_SUM == LCT_AGG
+#define PULL(t, v) (AGG(t, v).sum = AGG(t, v).w                         \
+                    + AGG(t, LEFT(t, v)).sum + AGG(t, RIGHT(t, v)).sum)
+#define LEAF(t, v, x) (AGG(t, v).w = AGG(t, v).sum = (x))
+#define NEUTRAL(t, v) LEAF(t, v, 0)
+#elif LCT_AGG_MINMAX == LCT_AGG
+#define PULL(t, v) (AGG(t, v).min = minW(AGG(t, v).w,                     \
+                                         minW(AGG(t, LEFT(t, v)).min,       \
+                                              AGG(t, RIGHT(t, v)).min)),    \
+                    AGG(t, v).max = maxW(AGG(t, v).w,                     \
+                                         maxW(AGG(t, LEFT(t, v)).max,       \
+                                              AGG(t, RIGHT(t, v)).max)))
+#define LEAF(t, v, x) (AGG(t, v).w = AGG(t, v).min = AGG(t, v).max = (x))
+#define NEUTRAL(t, v) (AGG(t, v).w = NAN, AGG(t, v).min = HUGE_VAL,        \
+                       AGG(t, v).max = -HUGE_VAL)
+#else
+#define PULL(t, v)
+#define LEAF(t, v, x)
+#define NEUTRAL(t, v)
+#endif /* LCT_AGG */
+
+/* Operation counters, see struct LCTStats. Compile with -D LCT_STATS to
+   keep them. */
+#ifdef LCT_STATS
+#define COUNT(t, f, n) ((t)->stats.f += (n))
+#define COUNT_CYCLE(t, c) countCycle(t, c)
+#else
+#define COUNT(t, f, n)
+#define COUNT_CYCLE(t, c)
+#endif /* LCT_STATS */
+
+/* Edge records, after the nodes, indexed by edge node. */
+#define EDGES(t) ((struct edge*)((char*)&(t)[1] + NODES(t)*sizeof(struct node)))
+#define EDGE(t, x) (EDGES(t)[(x) - (t)->V - 1])
+
+/* The undo log of t, kept in the struct LCTHead in front of it. */
+#define LOG(t) (((struct LCTHead*)(t))[-1].log)
+
+/* Scratch array of NODES(t) entries, in the struct LCTHead, out of the
+   block, so clone and checkpoints do not copy it. Holds aux tree paths. */
+#define STACK(t) (((struct LCTHead*)(t))[-1].stack)
+
 /*** file scope typedefs  *********************************/
 
-typedef struct LCT* LCTAux; /** Used to represent splay trees. */
-
-struct LCT { /** This structure is used to represent a node in the LCT. */
-  LCT left; /** Child */
-  LCT right; /** Child */
-  LCT* hook; /** Sort of parent pointer. Points directly to the position
-                 that points back to this node. If NULL means that it is the
-                 root of its sub-tree. It may point to a position that does
-                 not point back, in wich case it is an accross Aux parent
-                 pointer. */
-  int sum; /** For now the size of this sub-tree. Can be changed to sum of
-               weights. The value is assume to be >= 0. Negative values are
-               used to indicate that left and right pointers should be
-               swapped on the sub-tree. */
+typedef uint32_t LCTAux; /** Used to represent splay trees, by index. */
+
+#if LCT_AGG_SUM == LCT_AGG
+struct agg { /** Weight sum of an aux sub-tree. */
+  LCTWeight w; /** Weight of the node */
+  LCTWeight sum; /** Sum over the sub-tree */
+};
+#elif LCT_AGG_MINMAX == LCT_AGG
+struct agg { /** Weight range of an aux sub-tree. */
+  LCTWeight w; /** Weight of the node */
+  LCTWeight min; /** Minimum over the sub-tree */
+  LCTWeight max; /** Maximum over the sub-tree */
+};
+#endif /* LCT_AGG */
+
+struct node { /** This structure is used to represent a node in the LCT. */
+  uint32_t left; /** Child */
+  uint32_t right; /** Child */
+  uint32_t parent; /** Parent index. If 0 means that it is the root of its
+                       sub-tree. If the parent does not point back, it is
+                       an accross Aux parent pointer. */
+  int32_t sum; /** For now the size of this sub-tree. Can be changed to sum
+                   of weights. The value is assume to be >= 0. Negative
+                   values are used to indicate that left and right pointers
+                   should be swapped on the sub-tree. */
+#if LCT_AGG_SIZE != LCT_AGG
+  struct agg agg; /** Path aggregate, see LCT_AGG. With LCT_SOA this is
+                      stored in its own array, after the other fields. */
+#endif /* LCT_AGG */
+};
+
+struct edge { /** Edge stored in an edge node. */
+  int32_t id; /** Given when linking, -1 if none */
+  int32_t u; /** Endpoint, 0 when the node is free */
+  int32_t v; /** Endpoint */
+  int32_t next; /** Next free edge node */
+};
+
+struct undo { /** State of an edge node before a change. */
+  int32_t x; /** The edge node */
+  int32_t u; /** Endpoint, 0 if x was free */
+  int32_t v; /** Endpoint */
+  int32_t id; /** Identifier */
+  LCTWeight w; /** Weight */
+};
+
+struct LCTLog { /** Undo log, kept while a tree has snapshots. */
+  struct undo* U; /** Entries, oldest first */
+  size_t n; /** Number of entries */
+  size_t size; /** Allocated entries */
+  int snaps; /** Snapshots alive */
+  pthread_mutex_t lock; /** Guards U and n, for displaySnapshot */
+};
+
+struct LCTSnap {
+  LCT t; /** The tree */
+  size_t n; /** Entries of the log when the snapshot was taken */
+};
+
+struct LCTHead { /** Allocated in front of an LCT, out of its block, so
+                      the block holds no pointers. */
+  struct LCTLog* log; /** Undo log of the snapshots, NULL if none */
+  uint32_t* stack; /** The STACK, also keeps the LCT 16 byte aligned */
+};
+
+struct LCT { /** Header, the nodes follow it in the same block. */
+  int32_t V; /** Number of vertexes */
+  int32_t free; /** First free edge node, 0 if none */
+  uint32_t pad[2]; /** Keeps the nodes 16 byte aligned */
+#ifdef LCT_STATS
+  struct LCTStats stats; /** Operation counters, a multiple of 16 bytes */
+#endif /* LCT_STATS */
 };
 
 /*** global variables (externs or externables) ************/
 
 /*** file scope variables (static) ************************/
 
-static int ct = 1;
-static char sstat[100];
-
 /*** file scope functions declarations (static) ***********/
 
-/** Resets invariant properties of v */
-static void
-resetNode(LCTAux v /**< [in] */
-          );
+/** @return Size in bytes of an LCT over V vertexes. Header, nodes and
+    edges. Edges are nodes, so that evert and the path aggregates work on
+    them, and each has a record with its endpoints and id. A parent edge
+    array indexed by vertex would change along the whole path on every
+    evert. So there are 2V nodes of 16 bytes and V records of 16 bytes,
+    48 bytes per vertex, more with LCT_AGG. The STACK adds 8 bytes per
+    vertex, out of the block. */
+static size_t
+bytesLCT(int V /**< [in] */
+         );
 
 /** @return 1 if this struct is flipped, 0 otherwise */
 static int
-flippedQ(LCTAux v /**< [in] */
+flippedQ(LCT t /**< [in] */,
+         LCTAux v /**< [in] */
          );
 
-/** Changes a logical bit in the struct so that it behaves as flipped */
+/** Changes a logical bit in the struct so that it behaves as flipped.
+    With LCT_ROOTED reverses the aux tree of v right away, v must be the
+    root of an aux tree. */
 static void
-flip(LCTAux v /**< [in] */
-         );
+flip(LCT t /**< [in] */,
+     LCTAux v /**< [in] */
+     );
 
 /** Physically changes struct so that flip bit can be disabled. */
 static void
-unflip(LCTAux v /**< [in] */
-     );
+unflip(LCT t /**< [in] */,
+       LCTAux v /**< [in] */
+       );
 
 /** @return The size of the aux sub-tree rooted at v. */
 static int
-sizeAux(LCTAux v /**< [in] */
+sizeAux(LCT t /**< [in] */,
+        LCTAux v /**< [in] */
         );
 
 /** IMPORTANT: This function only applies if v is the root of a splay tree.
     Changes the lower pointer of v to to. */
 static void
-setLower(LCTAux v /**< [in] Must be root of a splay tree. */,
+setLower(LCT t /**< [in] */,
+         LCTAux v /**< [in] Must be root of a splay tree. */,
          LCTAux to /**< [in] */
          );
 
 /** @return 0 if s is NOT the root of the splay tree
     1 otherwise. */
 static int
-auxRootQ(LCTAux s /**< [in] */
+auxRootQ(LCT t /**< [in] */,
+         LCTAux s /**< [in] */
          );
 
 /** IMPORTANT: Assumes that the node is not flipped. Rotates node v, upwards. */
@@ -108,129 +298,371 @@ rotate(LCT t /**< [in] */,
        LCTAux v /**< [in] */
        );
 
-/** Splays u within its aux tree*/
+/** Restructures the aux tree of v, according to LCT_AUX. For LCT_SPLAY and
+    LCT_TOPDOWN v becomes the root. */
 static void
 splay(LCT t /**< [in] */,
       int v /**< [in] */
       );
 
-/** @return r, so that p points inside t[r]. */
-static int
-ptrToIndex(LCT t /**< [in] */,
-           void *p /**< [in] */
-           );
-
 /** @return The aux parent of s. */
 static int
 auxParent(LCT t /**< [in] */,
           LCTAux s /**< [in] */
           );
 
-/*** implementation ***************************************/
+/** Removes the flips from the path that goes from the root of the aux tree
+    to v.
+
+    @return The root of the aux tree of v. */
+static LCTAux
+rootAux(LCT t /**< [in] */,
+        LCTAux v /**< [in] */
+        );
 
+/** Makes the nodes after w, in depth order, into a separate aux tree, with
+    w as aux parent. Then appends the aux tree rooted at b after w. */
 static void
-resetNode(LCTAux v /**< [in] */
-          )
-{
-  int b;
+spliceAux(LCT t /**< [in] */,
+          LCTAux w /**< [in] */,
+          LCTAux b /**< [in] Root of an aux tree, or 0. */
+          );
 
-  b = 1;
-  if (flippedQ(v))
-    b = -1;
+/** @return The aux parent of the aux tree containing v. */
+static int
+pathParent(LCT t /**< [in] */,
+           LCTAux v /**< [in] */
+           );
 
-  v->sum = 0;
+#if LCT_SEMI == LCT_AUX || LCT_TREAP == LCT_AUX
+/** Splits the aux tree of v, v becomes the last node of the first part.
+    IMPORTANT: the path to v must not be flipped, see rootAux.
 
-  if (NULL != v->left) {
-    v->sum += sizeAux(v->left);
-    v->left->hook = &(v->left);
-  }
+    @return The root of the first part. The second part is at *r. */
+static LCTAux
+split(LCT t /**< [in] */,
+      LCTAux v /**< [in] */,
+      LCTAux* r /**< [out] Root of the second part, or 0. */
+      );
 
-  v->sum++; /* Adding the node */
+/** Appends aux tree b after aux tree a, w is the last node of a.
 
-  if (NULL != v->right) {
-    v->sum += sizeAux(v->right);
-    v->right->hook = &(v->right);
-  }
+    @return The root of the result. */
+static LCTAux
+join(LCT t /**< [in] */,
+     LCTAux a /**< [in] Root of an aux tree */,
+     LCTAux w /**< [in] Last node of a */,
+     LCTAux b /**< [in] Root of an aux tree, or 0. */
+     );
+#endif /* LCT_SEMI or LCT_TREAP */
 
-  v->sum *= b; /* Flip back */
+/** @return The number of nodes, vertexes and edges, on the path of x. */
+static int
+sizeNodes(LCT t /**< [in] */,
+          int x /**< [in] */
+          );
+
+/** @return The position of node x on its path, starting at 1. */
+static int
+positionNode(LCT t /**< [in] */,
+             int x /**< [in] */
+             );
+
+/** @return The i-th node on the path of x, 0 if out of bounds. */
+static int
+selectNode(LCT t /**< [in] */,
+           int x /**< [in] */,
+           int i /**< [in] Starting at 1 */
+           );
+
+/** Makes r the root of its tree and hangs it below v. */
+static void
+hang(LCT t /**< [in] */,
+     int r /**< [in] */,
+     int v /**< [in] */
+     );
+
+/** @return A free edge node for (u, v), with the given id. */
+static int
+newEdge(LCT t /**< [in] */,
+        int u /**< [in] */,
+        int v /**< [in] */,
+        int id /**< [in] */
+        );
+
+/** @return The weight of the edge node x, 1 when weights are not kept. */
+static LCTWeight
+edgeWeight(LCT t /**< [in] */,
+           int x /**< [in] */
+           );
+
+/** Appends the state of the edge node x to the undo log, if there are
+    snapshots. Call before changing the edge record or the weight of x. */
+static void
+logEdge(LCT t /**< [in] */,
+        int x /**< [in] */
+        );
+
+/** Removes the edge node x that links p to c. c becomes the root of its
+    tree and x is freed.
+    IMPORTANT: p, x and c must be consecutive, in this order, on one aux
+    tree.
+
+    @return The id of the edge. */
+static int
+removeEdge(LCT t /**< [in] */,
+           int p /**< [in] */,
+           int x /**< [in] */,
+           int c /**< [in] */
+           );
+
+/** Access that also reports where the path of v met the previous access.
+
+    @return The last aux parent crossed, or v if there was none. This is
+    the lowest common ancestor of v and the vertex accessed before. */
+static int
+expose(LCT t /**< [in] */,
+       int v /**< [in] */
+       );
+
+#ifdef LCT_ROOTED
+/** @return The parent of c in its tree, 0 for the root. */
+static int
+parentOf(LCT t /**< [in] */,
+         int c /**< [in] */
+         );
+
+/** Removes the edge between c and its parent.
+
+    @return The id of the edge. */
+static int
+cutParent(LCT t /**< [in] */,
+          int c /**< [in] */
+          );
+
+/** Exposes the path from the root to v, after measuring u. Depths count
+    nodes, so they are twice the number of edges.
+
+    @return The lowest common ancestor of u and v. */
+static int
+pathLca(LCT t /**< [in] */,
+        int u /**< [in] */,
+        int v /**< [in] */,
+        int* du /**< [out] Depth of u */,
+        int* dv /**< [out] Depth of v */,
+        int* dl /**< [out] Depth of the ancestor */
+        );
+
+/** Obtains the k-th edge on the path from u to v, after pathLca. *a is
+    the endpoint closer to u. The path with a, the edge and b is left
+    exposed.
+
+    @return The edge node. */
+static int
+selectPath(LCT t /**< [in] */,
+           int u /**< [in] */,
+           int v /**< [in] */,
+           int k /**< [in] */,
+           int du /**< [in] */,
+           int dl /**< [in] */,
+           int* a /**< [out] */,
+           int* b /**< [out] */
+           );
+#endif /* LCT_ROOTED */
+
+#ifdef LCT_STATS
+/** Adds cycle size c to the histogram. */
+static void
+countCycle(LCT t /**< [in] */,
+           int c /**< [in] */
+           );
+#endif /* LCT_STATS */
+
+#if LCT_AGG_MINMAX == LCT_AGG
+/** @return The smallest of a and b, b if a is NAN. */
+static LCTWeight
+minW(LCTWeight a /**< [in] */,
+     LCTWeight b /**< [in] */
+     );
+
+/** @return The largest of a and b, b if a is NAN. */
+static LCTWeight
+maxW(LCTWeight a /**< [in] */,
+     LCTWeight b /**< [in] */
+     );
+#endif /* LCT_AGG_MINMAX */
+
+#if LCT_AGG_SIZE != LCT_AGG
+/** @return The edge node of (u, v). IMPORTANT: edgeQ(t, u, v) must be
+    true. */
+static int
+edgeNode(LCT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */
+         );
+
+/** Recomputes the aggregates from x up to the root of its aux tree. */
+static void
+pullUp(LCT t /**< [in] */,
+       LCTAux x /**< [in] */
+       );
+#endif /* LCT_AGG */
+
+/** Replaces the k-th edge on the path from u to v, counting from u, by
+    the edge (u, v) with weight w. IMPORTANT: call right after the path
+    is exposed, by reRoot(u) and access(v), or by pathLca with LCT_ROOTED,
+    which gives du and dl.
+
+    @return The id of the removed edge. */
+static int
+replaceEdge(LCT t /**< [in] */,
+            int u /**< [in] */,
+            int v /**< [in] */,
+            int id /**< [in] */,
+            LCTWeight w /**< [in] */,
+            int k /**< [in] */,
+            int du /**< [in] */,
+            int dl /**< [in] */,
+            int* a /**< [out] Removed edge, endpoint closer to u */,
+            int* b /**< [out] */
+            );
+
+#if LCT_AGG_SUM == LCT_AGG
+/** Finds the edge node where the weight, added in order over the aux tree
+    rooted at s, goes over r.
+
+    @return The edge node. */
+static int
+selectWeight(LCT t /**< [in] */,
+             LCTAux s /**< [in] */,
+             LCTWeight r /**< [in] Between 0 and the sum of s */
+             );
+#endif /* LCT_AGG_SUM */
+
+/** Adds the aggregate of the aux tree rooted at s to p. */
+static void
+addPath(LCT t /**< [in] */,
+        LCTAux s /**< [in] */,
+        struct LCTPath* p /**< [in/out] */
+        );
+
+#if LCT_TREAP == LCT_AUX
+/** @return Pseudo random priority of v. */
+static uint32_t
+priority(LCTAux v /**< [in] */
+         );
+#endif /* LCT_TREAP */
+
+/*** implementation ***************************************/
+
+static size_t
+bytesLCT(int V
+         )
+{
+  size_t s;
+
+  s = sizeof(struct LCT) + 2*V*sizeof(struct node) + V*sizeof(struct edge);
+
+  return s;
 }
 
 static int
-flippedQ(LCTAux v
+flippedQ(LCT t,
+         LCTAux v
          )
 {
-  return 0 > v->sum;
+  return !LCT_EAGER && 0 > SUM(t, v);
 }
 
 static void
-flip(LCTAux v
+flip(LCT t,
+     LCTAux v
      )
 {
-  v->sum *= -1;
+#ifdef LCT_ROOTED
+  uint32_t* S;
+  int k;
+  LCTAux c;
+
+  S = STACK(t);
+  k = 0;
+  S[k++] = v;
+  while (0 < k) {
+    v = S[--k];
+    c = LEFT(t, v);
+    LEFT(t, v) = RIGHT(t, v);
+    RIGHT(t, v) = c;
+    if (0 != LEFT(t, v))
+      S[k++] = LEFT(t, v);
+    if (0 != RIGHT(t, v))
+      S[k++] = RIGHT(t, v);
+  }
+#else
+  SUM(t, v) *= -1;
+#endif /* LCT_ROOTED */
 }
 
 static void
-unflip(LCTAux v
-     )
+unflip(LCT t,
+       LCTAux v
+       )
 {
-  LCTAux t;
-  uint64_t ti;
+  LCTAux c;
 
-  if (flippedQ(v))
+  if (flippedQ(t, v))
     {
-      flip(v);
-      t = v->left;
-      v->left = v->right;
-      v->right = t;
-
-      if (NULL != v->left){
-        flip(v->left);
-	v->left->hook = &(v->left);
-      }
-      if (NULL != v->right){
-        flip(v->right);
-	v->right->hook = &(v->right);
-      }
+      COUNT(t, unflips, 1);
+      flip(t, v);
+      c = LEFT(t, v);
+      LEFT(t, v) = RIGHT(t, v);
+      RIGHT(t, v) = c;
+
+      if (0 != LEFT(t, v))
+        flip(t, LEFT(t, v));
+      if (0 != RIGHT(t, v))
+        flip(t, RIGHT(t, v));
     }
 }
 
 static int
-sizeAux(LCTAux v
+sizeAux(LCT t,
+        LCTAux v
         )
 {
-  int r;
-
-  r = 0;
-  if (NULL != v)
-    r = abs(v->sum);
-
-  return r;
+  if (LCT_EAGER)
+    return SUM(t, v);
+  return abs(SUM(t, v)); /* The sum of node 0 is 0 */
 }
 
 static void
-setLower(LCTAux v,
+setLower(LCT t,
+         LCTAux v,
          LCTAux to
          )
 {
-  unflip(v); /* Now branches are not flipped */
-  v->sum -= sizeAux(v->right);
-  v->right = to;
-  v->sum += sizeAux(v->right);
-
-  if (NULL != v->right)
-    v->right->hook = &(v->right);
-
+  unflip(t, v); /* Now branches are not flipped */
+  SUM(t, v) -= sizeAux(t, RIGHT(t, v));
+  RIGHT(t, v) = to;
+  SUM(t, v) += sizeAux(t, to);
+  PULL(t, v);
+
+  if (0 != to)
+    PARENT(t, to) = v;
 }
 
 static int
-auxRootQ(LCTAux s
+auxRootQ(LCT t,
+         LCTAux s
          )
 {
   int r;
+  LCTAux p;
+
   r = 0;
-  if(NULL == s->hook)
+  p = PARENT(t, s);
+  if (0 == p)
     r = 1;
-  else if (s != *(s->hook))
+  else if (s != LEFT(t, p) && s != RIGHT(t, p))
     r = 1;
 
   return r;
@@ -241,114 +673,868 @@ rotate(LCT t,
        LCTAux v
        )
 {
-  int p; /* Parent node */
+  LCTAux p; /* Parent node */
+  LCTAux g; /* Grand parent node, or aux parent */
+  LCTAux c; /* Child that changes sides */
   int vs; /* Temporary v size */
 
-  assert(!flippedQ(v) && "Trying to rotate flipped node.");
+  assert(!flippedQ(t, v) && "Trying to rotate flipped node.");
+
+  if (!auxRootQ(t, v)) { /* Rotation is possible */
+    COUNT(t, rotations, 1);
+    p = PARENT(t, v);
+    g = PARENT(t, p);
+    assert(!flippedQ(t, p) && "Trying to rotate flipped node.");
+
+    vs = sizeAux(t, v);
+    /* Reseting copies values for v */
+    SUM(t, v) = SUM(t, p);
+
+    /* Reseting updates values for v */
+    SUM(t, p) -= vs;
+
+    if (v == LEFT(t, p)) {
+      c = RIGHT(t, v);
+      LEFT(t, p) = c;
+      RIGHT(t, v) = p;
+    } else {
+      c = LEFT(t, v);
+      RIGHT(t, p) = c;
+      LEFT(t, v) = p;
+    }
+    SUM(t, p) += sizeAux(t, c);
+    if (0 != c)
+      PARENT(t, c) = p;
+
+    if (0 != g) { /* Also keeps accross Aux parent pointers */
+      if (p == LEFT(t, g))
+        LEFT(t, g) = v;
+      else if (p == RIGHT(t, g))
+        RIGHT(t, g) = v;
+    }
+    PARENT(t, v) = g;
+    PARENT(t, p) = v;
+    PULL(t, p);
+    PULL(t, v);
+
+    assert(0 != SUM(t, p) && "Size set to 0");
+    assert(0 != SUM(t, v) && "Size set to 0");
+  }
+}
+
+#if LCT_SPLAY == LCT_AUX
+static void
+splay(LCT t,
+      int v
+      )
+{
+  LCTAux p; /* Parent node */
+  LCTAux g; /* Grand parent node */
+
+  COUNT(t, splays, 1);
+  while(0 == auxRootQ(t, v)) { /* Not at the root of a splay tree */
+    p = auxParent(t, v);
+
+    if (0 == auxRootQ(t, p)) { /* Then v has a grand parent */
+      g = auxParent(t, p);
+      unflip(t, g);
+      unflip(t, p);
+      unflip(t, v);
+
+      if ((v == LEFT(t, p)) == (p == LEFT(t, g))) /* Zig Zig case */
+        rotate(t, p);
+      else /* Zig Zag case */
+        rotate(t, v);
+    }
+    unflip(t, p); /* Zig case precaution */
+    unflip(t, v);
+    rotate(t, v); /* Both cases and Zig */
+  }
+
+}
+#endif /* LCT_SPLAY */
+
+#if LCT_TOPDOWN == LCT_AUX
+static void
+splay(LCT t,
+      int v
+      )
+{
+  uint32_t* S; /* Path from v to the root, v at S[0] */
+  int k; /* Number of nodes on S */
+  LCTAux c; /* Current root of the middle tree */
+  LCTAux y; /* Next node on the path */
+  LCTAux pp; /* Aux parent of the tree */
+  LCTAux l; /* Root of the left tree */
+  LCTAux lt; /* Largest node of the left tree */
+  LCTAux r; /* Root of the right tree */
+  LCTAux rt; /* Smallest node of the right tree */
+
+  COUNT(t, splays, 1);
+  S = STACK(t);
+  k = 0;
+  c = v;
+  while (0 == auxRootQ(t, c)) {
+    S[k] = c;
+    k++;
+    c = PARENT(t, c);
+  }
+
+  if (0 < k) {
+    pp = PARENT(t, c);
+    l = 0;
+    lt = 0;
+    r = 0;
+    rt = 0;
+
+    unflip(t, c);
+    while (c != v) {
+      k--;
+      y = S[k];
+      unflip(t, y);
+
+      if (y == LEFT(t, c)) {
+        if (y != v && S[k-1] == LEFT(t, y)) { /* Zig Zig, rotate right */
+          COUNT(t, rotations, 1);
+          LEFT(t, c) = RIGHT(t, y);
+          if (0 != LEFT(t, c))
+            PARENT(t, LEFT(t, c)) = c;
+          RIGHT(t, y) = c;
+          PARENT(t, c) = y;
+          SUM(t, c) = 1 + sizeAux(t, LEFT(t, c)) + sizeAux(t, RIGHT(t, c));
+          PULL(t, c);
+          c = y;
+          k--;
+          y = S[k];
+          unflip(t, y);
+        }
+        /* Link right */
+        if (0 == rt)
+          r = c;
+        else {
+          LEFT(t, rt) = c;
+          PARENT(t, c) = rt;
+        }
+        rt = c;
+      } else {
+        if (y != v && S[k-1] == RIGHT(t, y)) { /* Zag Zag, rotate left */
+          COUNT(t, rotations, 1);
+          RIGHT(t, c) = LEFT(t, y);
+          if (0 != RIGHT(t, c))
+            PARENT(t, RIGHT(t, c)) = c;
+          LEFT(t, y) = c;
+          PARENT(t, c) = y;
+          SUM(t, c) = 1 + sizeAux(t, LEFT(t, c)) + sizeAux(t, RIGHT(t, c));
+          PULL(t, c);
+          c = y;
+          k--;
+          y = S[k];
+          unflip(t, y);
+        }
+        /* Link left */
+        if (0 == lt)
+          l = c;
+        else {
+          RIGHT(t, lt) = c;
+          PARENT(t, c) = lt;
+        }
+        lt = c;
+      }
+      c = y;
+    }
+
+    /* Assemble, then fix sizes bottom up along the spines */
+    if (0 != lt) {
+      RIGHT(t, lt) = LEFT(t, v);
+      if (0 != LEFT(t, v))
+        PARENT(t, LEFT(t, v)) = lt;
+      while (lt != l) {
+        SUM(t, lt) = 1 + sizeAux(t, LEFT(t, lt)) + sizeAux(t, RIGHT(t, lt));
+        PULL(t, lt);
+        lt = PARENT(t, lt);
+      }
+      SUM(t, l) = 1 + sizeAux(t, LEFT(t, l)) + sizeAux(t, RIGHT(t, l));
+      PULL(t, l);
+      LEFT(t, v) = l;
+      PARENT(t, l) = v;
+    }
+    if (0 != rt) {
+      LEFT(t, rt) = RIGHT(t, v);
+      if (0 != RIGHT(t, v))
+        PARENT(t, RIGHT(t, v)) = rt;
+      while (rt != r) {
+        SUM(t, rt) = 1 + sizeAux(t, LEFT(t, rt)) + sizeAux(t, RIGHT(t, rt));
+        PULL(t, rt);
+        rt = PARENT(t, rt);
+      }
+      SUM(t, r) = 1 + sizeAux(t, LEFT(t, r)) + sizeAux(t, RIGHT(t, r));
+      PULL(t, r);
+      RIGHT(t, v) = r;
+      PARENT(t, r) = v;
+    }
+    SUM(t, v) = 1 + sizeAux(t, LEFT(t, v)) + sizeAux(t, RIGHT(t, v));
+    PULL(t, v);
+    PARENT(t, v) = pp;
+  }
+}
+#endif /* LCT_TOPDOWN */
+
+#if LCT_SEMI == LCT_AUX
+static void
+splay(LCT t,
+      int v
+      )
+{
+  LCTAux p; /* Parent node */
+  LCTAux g; /* Grand parent node */
+
+  COUNT(t, splays, 1);
+  while(0 == auxRootQ(t, v)) { /* Not at the root of a splay tree */
+    p = auxParent(t, v);
+
+    if (0 == auxRootQ(t, p)) { /* Then v has a grand parent */
+      g = auxParent(t, p);
+      unflip(t, g);
+      unflip(t, p);
+      unflip(t, v);
+
+      if ((v == LEFT(t, p)) == (p == LEFT(t, g))) { /* Zig Zig case */
+        rotate(t, p);
+        v = p; /* Continue from the parent */
+      } else { /* Zig Zag case */
+        rotate(t, v);
+        rotate(t, v);
+      }
+    } else {
+      unflip(t, p); /* Zig case */
+      unflip(t, v);
+      rotate(t, v);
+    }
+  }
+
+}
+#endif /* LCT_SEMI */
+
+#if LCT_TREAP == LCT_AUX
+static void
+splay(LCT t,
+      int v
+      )
+{
+  /* Treaps are not restructured by accesses */
+  COUNT(t, splays, 1);
+}
+
+static uint32_t
+priority(LCTAux v
+         )
+{
+  v ^= v >> 16;
+  v *= 0x7feb352dU;
+  v ^= v >> 15;
+  v *= 0x846ca68bU;
+  v ^= v >> 16;
+
+  return v;
+}
+#endif /* LCT_TREAP */
+
+static int
+auxParent(LCT t,
+          LCTAux s
+          )
+{
+  return PARENT(t, s);
+}
+
+#if LCT_SPLAY == LCT_AUX || LCT_TOPDOWN == LCT_AUX
+static LCTAux
+rootAux(LCT t,
+        LCTAux v
+        )
+{
+  splay(t, v);
+  unflip(t, v);
+
+  return v;
+}
+
+static void
+spliceAux(LCT t,
+          LCTAux w,
+          LCTAux b
+          )
+{
+  splay(t, w);
+  setLower(t, w, b);
+}
+#endif /* LCT_SPLAY or LCT_TOPDOWN */
+
+#if LCT_SEMI == LCT_AUX || LCT_TREAP == LCT_AUX
+static LCTAux
+rootAux(LCT t,
+        LCTAux v
+        )
+{
+  uint32_t* S; /* Path from v to the root, v at S[0] */
+  int k;
+
+  splay(t, v);
+
+  S = STACK(t);
+  k = 0;
+  S[k] = v;
+  while (0 == auxRootQ(t, v)) {
+    v = PARENT(t, v);
+    k++;
+    S[k] = v;
+  }
+
+  while (0 <= k) { /* Top down */
+    unflip(t, S[k]);
+    k--;
+  }
+
+  return v;
+}
+
+static void
+spliceAux(LCT t,
+          LCTAux w,
+          LCTAux b
+          )
+{
+  LCTAux pp; /* Aux parent of the tree */
+  LCTAux a; /* First part */
+  LCTAux r; /* Second part */
+
+  pp = PARENT(t, rootAux(t, w));
+  a = split(t, w, &r);
+  if (0 != r)
+    PARENT(t, r) = w;
+  a = join(t, a, w, b);
+  PARENT(t, a) = pp;
+}
+
+static LCTAux
+split(LCT t,
+      LCTAux v,
+      LCTAux* r
+      )
+{
+  LCTAux l; /* Root of the first part */
+  LCTAux x; /* Current node */
+  LCTAux p; /* Its parent */
+
+  l = v;
+  *r = RIGHT(t, v);
+  RIGHT(t, v) = 0;
+  SUM(t, v) = 1 + sizeAux(t, LEFT(t, v));
+  PULL(t, v);
+
+  x = v;
+  while (0 == auxRootQ(t, x)) {
+    p = PARENT(t, x);
+    if (x == LEFT(t, p)) { /* p goes to the second part */
+      LEFT(t, p) = *r;
+      if (0 != *r)
+        PARENT(t, *r) = p;
+      *r = p;
+    } else { /* p goes to the first part */
+      RIGHT(t, p) = l;
+      PARENT(t, l) = p;
+      l = p;
+    }
+    SUM(t, p) = 1 + sizeAux(t, LEFT(t, p)) + sizeAux(t, RIGHT(t, p));
+    PULL(t, p);
+    x = p;
+  }
+
+  return l;
+}
+#endif /* LCT_SEMI or LCT_TREAP */
+
+#if LCT_SEMI == LCT_AUX
+static LCTAux
+join(LCT t,
+     LCTAux a,
+     LCTAux w,
+     LCTAux b
+     )
+{
+  int s;
+
+  if (0 != b) {
+    s = sizeAux(t, b);
+    RIGHT(t, w) = b; /* After split w has no right child */
+    PARENT(t, b) = w;
+    SUM(t, w) += s;
+    PULL(t, w);
+    while (w != a) {
+      w = PARENT(t, w);
+      SUM(t, w) += s;
+      PULL(t, w);
+    }
+  }
+
+  return a;
+}
+#endif /* LCT_SEMI */
+
+#if LCT_TREAP == LCT_AUX
+static LCTAux
+join(LCT t,
+     LCTAux a,
+     LCTAux w,
+     LCTAux b
+     )
+{
+  LCTAux r;
+
+  r = a;
+  if (0 == a)
+    r = b;
+  else if (0 != b) {
+    if (priority(a) > priority(b)) {
+      unflip(t, a);
+      RIGHT(t, a) = join(t, RIGHT(t, a), w, b);
+      PARENT(t, RIGHT(t, a)) = a;
+    } else {
+      r = b;
+      unflip(t, b);
+      LEFT(t, b) = join(t, a, w, LEFT(t, b));
+      PARENT(t, LEFT(t, b)) = b;
+    }
+    SUM(t, r) = 1 + sizeAux(t, LEFT(t, r)) + sizeAux(t, RIGHT(t, r));
+    PULL(t, r);
+  }
+
+  return r;
+}
+#endif /* LCT_TREAP */
+
+static int
+pathParent(LCT t,
+           LCTAux v
+           )
+{
+  return PARENT(t, rootAux(t, v));
+}
+
+static int
+sizeNodes(LCT t,
+          int x
+          )
+{
+  return sizeAux(t, rootAux(t, x));
+}
+
+static int
+positionNode(LCT t,
+             int x
+             )
+{
+  int r;
+  LCTAux p;
+
+  rootAux(t, x); /* Path to x is not flipped */
+  r = 1 + sizeAux(t, LEFT(t, x));
+  while (0 == auxRootQ(t, x)) {
+    p = PARENT(t, x);
+    if (x == RIGHT(t, p))
+      r += 1 + sizeAux(t, LEFT(t, p));
+    x = p;
+  }
+
+  return r;
+}
+
+static int
+selectNode(LCT t,
+           int x,
+           int i
+           )
+{
+  int r;
+  LCTAux s;
+  r = 0; /* Default for out of bounds */
+
+  s = rootAux(t, x);
+  if (0 < i && sizeAux(t, s) >= i) {
+    i--; /* Converted to how many elements do you need on the left */
+    while (sizeAux(t, LEFT(t, s)) != i) {
+      if (sizeAux(t, LEFT(t, s)) > i)
+        s = LEFT(t, s);
+      else {
+        i -= sizeAux(t, s);
+        s = RIGHT(t, s);
+        i += sizeAux(t, s);
+      }
+      unflip(t, s);
+    }
+    r = (int) s;
+    splay(t, r);
+  }
+
+  return r;
+}
+
+static void
+hang(LCT t,
+     int r,
+     int v
+     )
+{
+  reRoot(t, r);
+  access(t, v);
+  spliceAux(t, v, rootAux(t, r));
+}
+
+static int
+newEdge(LCT t,
+        int u,
+        int v,
+        int id
+        )
+{
+  int x;
+
+  x = t->free;
+  assert(0 != x && "No free edge nodes");
+  logEdge(t, x);
+  t->free = EDGE(t, x).next;
+
+  EDGE(t, x).id = id;
+  EDGE(t, x).u = u;
+  EDGE(t, x).v = v;
+  LEFT(t, x) = 0;
+  RIGHT(t, x) = 0;
+  PARENT(t, x) = 0;
+  SUM(t, x) = 1;
+  LEAF(t, x, 1);
+
+  return x;
+}
+
+static LCTWeight
+edgeWeight(LCT t,
+           int x
+           )
+{
+#if LCT_AGG_SIZE != LCT_AGG
+  return AGG(t, x).w;
+#else
+  return 1;
+#endif /* LCT_AGG */
+}
+
+static void
+logEdge(LCT t,
+        int x
+        )
+{
+  struct LCTLog* L;
+  struct undo* e;
+
+  L = LOG(t);
+  if (NULL != L) {
+    pthread_mutex_lock(&L->lock);
+    if (L->n == L->size) {
+      L->size = 0 < L->size ? 2*L->size : 64;
+      L->U = (struct undo*) realloc(L->U, L->size*sizeof(struct undo));
+    }
+    e = &L->U[L->n];
+    e->x = x;
+    e->u = EDGE(t, x).u;
+    e->v = EDGE(t, x).v;
+    e->id = EDGE(t, x).id;
+    e->w = edgeWeight(t, x);
+    L->n++;
+    pthread_mutex_unlock(&L->lock);
+  }
+}
+
+static int
+removeEdge(LCT t,
+           int p,
+           int x,
+           int c
+           )
+{
+  spliceAux(t, p, 0); /* x and c are now an aux tree below p */
+  PARENT(t, rootAux(t, x)) = 0;
+  spliceAux(t, x, 0); /* c is now an aux tree below x */
+  PARENT(t, rootAux(t, c)) = 0;
+
+  assert(1 == sizeNodes(t, x) && "Edge node still linked");
+  logEdge(t, x);
+  EDGE(t, x).u = 0;
+  EDGE(t, x).next = t->free;
+  t->free = x;
+
+  return EDGE(t, x).id;
+}
+
+static int
+expose(LCT t,
+       int v
+       )
+{
+  int w;
+  int l;
+
+  spliceAux(t, v, 0);
+
+  l = v;
+  w = pathParent(t, v);
+  while(0 != w) {
+    COUNT(t, changes, 1);
+    l = w;
+    spliceAux(t, w, rootAux(t, v));
+    w = pathParent(t, v);
+  }
+  COUNT(t, accesses, 1);
+  COUNT(t, length, sizeNodes(t, v));
+
+  assert(positionNode(t, v) == sizeNodes(t, v) && "Failed access invariant.");
 
-  if (!auxRootQ(v)) { /* Rotation is possible */
-    p = auxParent(t, v);
-    assert(!flippedQ(&t[p]) && "Trying to rotate flipped node.");
+  return l;
+}
 
-    vs = sizeAux(v);
-    /* Reseting copies values for v */
-    v->sum = t[p].sum;
+#ifdef LCT_ROOTED
+static int
+parentOf(LCT t,
+         int c
+         )
+{
+  int k;
 
-    /* Reseting updates values for v */
-    t[p].sum -= vs;
+  access(t, c);
+  k = sizeNodes(t, c);
 
-    if (v->hook == &(t[p].left)) {
-      t[p].sum += sizeAux(v->right);
+  return 1 < k ? selectNode(t, c, k-2) : 0;
+}
 
-      *(v->hook) = v->right;
-      if(NULL != *(v->hook))
-	(*(v->hook))->hook = v->hook;
+static int
+cutParent(LCT t,
+          int c
+          )
+{
+  int k;
 
-      v->hook = t[p].hook;
-      if (NULL != v->hook && (LCT)&t[p] == *v->hook)
-	*(v->hook) = v;
+  access(t, c);
+  k = sizeNodes(t, c);
 
-      v->right = &(t[p]);
-      v->right->hook = &(v->right);
-    } else {
-      t[p].sum += sizeAux(v->left);
+  return removeEdge(t, selectNode(t, c, k-2), selectNode(t, c, k-1), c);
+}
 
-      *(v->hook) = v->left;
-      if(NULL != *(v->hook))
-	(*(v->hook))->hook = v->hook;
+static int
+pathLca(LCT t,
+        int u,
+        int v,
+        int* du,
+        int* dv,
+        int* dl
+        )
+{
+  int l;
 
-      v->hook = t[p].hook;
-      if (NULL != v->hook && (LCT)&t[p] == *v->hook)
-	*(v->hook) = v;
+  access(t, u);
+  *du = sizeNodes(t, u) - 1;
+  l = expose(t, v);
+  *dv = sizeNodes(t, v) - 1;
+  *dl = positionNode(t, l) - 1;
 
-      v->left = &(t[p]);
-      v->left->hook = &(v->left);
-    }
+  return l;
+}
 
-    assert(0 != t[p].sum && "Size set to 0");
-    assert(0 != v->sum && "Size set to 0");
+static int
+selectPath(LCT t,
+           int u,
+           int v,
+           int k,
+           int du,
+           int dl,
+           int* a,
+           int* b
+           )
+{
+  int x;
+
+  k *= 2; /* Index of the edge node on the path, u is 1 */
+  if (k <= du - dl) { /* Going up from u */
+    access(t, u);
+    *b = selectNode(t, u, du - k + 1);
+    *a = selectNode(t, u, du - k + 3);
+    x = selectNode(t, u, du - k + 2);
+  } else { /* Going down to v, its path is still exposed */
+    k -= du - dl;
+    *b = selectNode(t, v, dl + k + 1);
+    *a = selectNode(t, v, dl + k - 1);
+    x = selectNode(t, v, dl + k);
   }
+
+  return x;
 }
+#endif /* LCT_ROOTED */
 
+#ifdef LCT_STATS
 static void
-splay(LCT t,
-      int v
-      )
+countCycle(LCT t,
+           int c
+           )
 {
-  int p; /* Parent node */
-  int g; /* Grand parent node */
-  intptr_t pt; /* Integer pointer */
+  int b;
+
+  b = 0;
+  while (b+1 < LCT_HIST && 0 != (c >> (b+1)))
+    b++;
+  t->stats.cycles[b]++;
+  t->stats.cycleNr++;
+  t->stats.cycleSum += c;
+}
+#endif /* LCT_STATS */
 
-  while(0 == auxRootQ(&t[v])) { /* Not at the root of a splay tree */
-    p = auxParent(t, &t[v]);
+#if LCT_AGG_MINMAX == LCT_AGG
+static LCTWeight
+minW(LCTWeight a,
+     LCTWeight b
+     )
+{
+  return a < b ? a : b;
+}
 
-    if (0 == auxRootQ(&t[p])) { /* Then v has a grand parent */
-      g = auxParent(t, &t[p]);
-      unflip(&t[g]);
-      unflip(&t[p]);
-      unflip(&t[v]);
+static LCTWeight
+maxW(LCTWeight a,
+     LCTWeight b
+     )
+{
+  return a > b ? a : b;
+}
+#endif /* LCT_AGG_MINMAX */
 
-      pt = (intptr_t) t[v].hook;
-      pt -= (intptr_t) t[p].hook;
-      pt %= sizeof(struct LCT);
+#if LCT_AGG_SIZE != LCT_AGG
+static int
+edgeNode(LCT t,
+         int u,
+         int v
+         )
+{
+#ifdef LCT_ROOTED
+  if (parentOf(t, v) != u)
+    v = u; /* The child is u */
+  access(t, v);
+  return selectNode(t, v, sizeNodes(t, v) - 1);
+#else
+  reRoot(t, u);
+  access(t, v); /* The path is u x v */
+  return selectNode(t, v, 2);
+#endif /* LCT_ROOTED */
+}
 
-      if (0 == pt) /* Zig Zig case */
-        rotate(t, &t[p]);
-      else /* Zig Zag case */
-        rotate(t, &t[v]);
-    }
-    unflip(&t[p]); /* Zig case precaution */
-    unflip(&t[v]);
-    rotate(t, &t[v]); /* Both cases and Zig */
+static void
+pullUp(LCT t,
+       LCTAux x
+       )
+{
+  PULL(t, x);
+  while (0 == auxRootQ(t, x)) {
+    x = PARENT(t, x);
+    PULL(t, x);
   }
-
 }
+#endif /* LCT_AGG */
 
 static int
-ptrToIndex(LCT t,
-           void *p
-           )
+replaceEdge(LCT t,
+            int u,
+            int v,
+            int id,
+            LCTWeight w,
+            int k,
+            int du,
+            int dl,
+            int* a,
+            int* b
+            )
 {
+  int x; /* Edge node, removed and then reused */
   int r;
-  intptr_t pr; /* Integer pointer */
-  r = 0;
 
-  if (NULL != p) {
-    pr = (intptr_t) p;
-    pr -= (intptr_t) t;
-    pr /= sizeof(struct LCT);
-    r = (int) pr;
+#ifdef LCT_ROOTED
+  x = selectPath(t, u, v, k, du, dl, a, b);
+
+  if (2*k <= du - dl) { /* u is below the removed edge */
+    r = removeEdge(t, *b, x, *a);
+    x = newEdge(t, u, v, id);
+    LEAF(t, x, w);
+    reRoot(t, u);
+    PARENT(t, x) = v;
+    PARENT(t, rootAux(t, u)) = x;
+  } else {
+    r = removeEdge(t, *a, x, *b);
+    x = newEdge(t, u, v, id);
+    LEAF(t, x, w);
+    reRoot(t, v);
+    PARENT(t, x) = u;
+    PARENT(t, rootAux(t, v)) = x;
   }
+#else
+  *b = selectNode(t, v, 2*k + 1);
+  x = selectNode(t, v, 2*k);
+  *a = selectNode(t, v, 2*k - 1);
+
+  r = removeEdge(t, *a, x, *b); /* b is the root of its tree */
+  flip(t, rootAux(t, *b)); /* Now v is the root */
+  x = newEdge(t, u, v, id);
+  LEAF(t, x, w);
+  PARENT(t, rootAux(t, v)) = x;
+  PARENT(t, x) = u;
+#endif /* LCT_ROOTED */
 
   return r;
 }
 
+#if LCT_AGG_SUM == LCT_AGG
 static int
-auxParent(LCT t,
-          LCTAux s
-          )
+selectWeight(LCT t,
+             LCTAux s,
+             LCTWeight r
+             )
+{
+  while (1) {
+    unflip(t, s);
+    if (r < AGG(t, LEFT(t, s)).sum)
+      s = LEFT(t, s);
+    else {
+      r -= AGG(t, LEFT(t, s)).sum;
+      if (r < AGG(t, s).w || 0 == RIGHT(t, s))
+        break; /* The second test guards against rounding */
+      r -= AGG(t, s).w;
+      s = RIGHT(t, s);
+    }
+  }
+  splay(t, s);
+
+  if (s <= (LCTAux)t->V) /* Rounding ended on the last vertex */
+    s = selectNode(t, s, positionNode(t, s) - 1);
+
+  return s;
+}
+#endif /* LCT_AGG_SUM */
+
+static void
+addPath(LCT t,
+        LCTAux s,
+        struct LCTPath* p
+        )
 {
-  return ptrToIndex(t, s->hook);
+#if LCT_AGG_SUM == LCT_AGG
+  p->sum += AGG(t, s).sum;
+#elif LCT_AGG_MINMAX == LCT_AGG
+  p->min = minW(p->min, AGG(t, s).min);
+  p->max = maxW(p->max, AGG(t, s).max);
+#endif /* LCT_AGG */
 }
 
 /* End of Static Functions */
@@ -357,11 +1543,15 @@ LCT
 allocLCT(int V /**< [in] Number of vertexes of the underlying graph */
          )
 {
+  struct LCTHead* h;
   LCT t;
-  int i;
 
-  t = (LCT) malloc((V+1)*sizeof(struct LCT));
-  *(int*)t = V; /* Store number of vertexes */
+  h = (struct LCTHead*) hugeAlloc(sizeof(struct LCTHead) + bytesLCT(V), 0,
+                                  "link-cut tree");
+  t = (LCT) &h[1];
+  t->V = V; /* Store number of vertexes */
+  LOG(t) = NULL;
+  STACK(t) = (uint32_t*) malloc(NODES(t)*sizeof(uint32_t));
 
   cleanLCT(t);
 
@@ -376,46 +1566,53 @@ cleanLCT(LCT t /** [in] The tree to clean up */
   int V;
   V = vertexNr(t);
 
-  i = V;
+  assert(NULL == LOG(t) && "Cleaning a tree with snapshots");
+
+  i = 2*V - 1;
   while(0 < i){
-    t[i].left = NULL;
-    t[i].right = NULL;
-    t[i].hook = NULL;
-    t[i].sum = 1;
+    LEFT(t, i) = 0;
+    RIGHT(t, i) = 0;
+    PARENT(t, i) = 0;
+    SUM(t, i) = 1;
+    NEUTRAL(t, i);
+    i--;
+  }
+
+  LEFT(t, 0) = 0; /* The NULL node */
+  RIGHT(t, 0) = 0;
+  PARENT(t, 0) = 0;
+  SUM(t, 0) = 0;
+  NEUTRAL(t, 0);
+
+  t->free = 0; /* Chain the edge nodes, lowest first */
+  i = 2*V - 1;
+  while(V < i){
+    EDGE(t, i).u = 0;
+    EDGE(t, i).next = t->free;
+    t->free = i;
     i--;
   }
+
+#ifdef LCT_STATS
+  memset(&t->stats, 0, sizeof(struct LCTStats));
+#endif /* LCT_STATS */
 }
 
 LCT
 clone(LCT t
       )
 {
+  struct LCTHead* h;
   LCT c; /** The clone */
-  int i;
-  int V;
-  ptrdiff_t delta;
+  size_t s;
 
-  V = vertexNr(t);
-  c = (LCT) malloc((V+1)*sizeof(struct LCT));
-  *(int*)c = V; /* Store number of vertexes */
-
-  delta = (ptrdiff_t)c - (ptrdiff_t)t;
-
-  i = V;
-  while(0 < i) {
-      c[i].left = NULL;
-      if(NULL != t[i].left)
-        c[i].left = (LCT)(delta + (ptrdiff_t)t[i].left);
-      c[i].right = NULL;
-      if(NULL != t[i].right)
-        c[i].right = (LCT)(delta + (ptrdiff_t)t[i].right);
-      c[i].hook = NULL;
-      if(NULL != t[i].hook)
-        c[i].hook = (LCT*)(delta + (ptrdiff_t)t[i].hook);
-
-      c[i].sum = t[i].sum;
-      i--;
-    }
+  s = bytesLCT(vertexNr(t));
+  h = (struct LCTHead*) hugeAlloc(sizeof(struct LCTHead) + s, 0,
+                                  "link-cut tree");
+  c = (LCT) &h[1];
+  memcpy(c, t, s); /* Indexes need no relocation */
+  LOG(c) = NULL; /* Snapshots belong to t */
+  STACK(c) = (uint32_t*) malloc(NODES(c)*sizeof(uint32_t));
 
   return c;
 }
@@ -426,13 +1623,70 @@ array2LCT(int v,
 	  LCT O
 	  )
 {
-  int i; /* counter */
+  assert(v == vertexNr(O) && "Sizes differ");
 
   cleanLCT(O);
+  buildLCT(O, A, NULL);
+}
+
+void
+LCT2array(LCT t,
+          int* A
+          )
+{
+  uint32_t* S; /* Nodes to visit, shifted, with the flip parity */
+  int k;
+  int i;
+  int V;
+  LCTAux x;
+  LCTAux e; /* Node before x on its path, an edge node or 0 */
+  int p; /* Parity of the flips from the aux root to x */
+
+  V = vertexNr(t);
+  S = STACK(t);
+
+  i = 1;
+  while (i < 2*V) {
+    if (auxRootQ(t, i) && (i <= V || 0 != EDGE(t, i).u)) {
+      e = PARENT(t, i); /* Path parent, above the first node */
+      x = i;
+      p = 0;
+      k = 0;
+      while (0 != x || 0 < k) { /* In order, reading the flips */
+        while (0 != x) {
+          p ^= flippedQ(t, x);
+          S[k++] = x << 1 | p;
+          x = p ? RIGHT(t, x) : LEFT(t, x);
+        }
+        k--;
+        x = S[k] >> 1;
+        p = S[k] & 1;
+        if ((int)x <= V)
+          A[x] = 0 == e ? 0 : EDGE(t, e).u + EDGE(t, e).v - x;
+        e = x;
+        x = p ? LEFT(t, x) : RIGHT(t, x);
+      }
+    }
+    i++;
+  }
+}
+
+void
+buildLCT(LCT t,
+         int* parent,
+         int* id
+         )
+{
+  int i;
+  int x;
+
   i = 1;
-  while(i <= v){
-    if(0 < A[i])
-      link(O, i, A[i]);
+  while(i <= vertexNr(t)){
+    if(0 < parent[i]){ /* Path parent pointers, no preferred paths yet */
+      x = newEdge(t, i, parent[i], NULL != id ? id[i] : -1);
+      PARENT(t, i) = x;
+      PARENT(t, x) = parent[i];
+    }
     i++;
   }
 }
@@ -441,13 +1695,98 @@ int
 vertexNr(LCT t
          )
 {
-  return *(int*)t;
+  return t->V;
+}
+
+void
+prefetchLCT(LCT t,
+            int v
+            )
+{
+#ifdef LCT_SOA
+  __builtin_prefetch(&LEFT(t, v));
+  __builtin_prefetch(&RIGHT(t, v));
+  __builtin_prefetch(&PARENT(t, v));
+  __builtin_prefetch(&SUM(t, v));
+#if LCT_AGG_SIZE != LCT_AGG
+  __builtin_prefetch(&AGG(t, v));
+#endif /* LCT_AGG */
+#else
+  __builtin_prefetch(&NODE(t, v));
+#endif /* LCT_SOA */
+}
+
+int
+aboveLCT(LCT t,
+         int v
+         )
+{
+  return PARENT(t, v);
+}
+
+void
+statsLCT(LCT t,
+         FILE *f
+         )
+{
+#ifdef LCT_STATS
+  struct LCTStats* s;
+  double n;
+  int i;
+
+  s = &t->stats;
+  n = s->accesses ? (double)s->accesses : 1.0;
+  fprintf(f, "accesses %" PRIu64 "\n", s->accesses);
+  fprintf(f, "preferred path changes per access %.2f\n", s->changes/n);
+  fprintf(f, "exposed path size per access %.2f\n", s->length/n);
+  fprintf(f, "splays %" PRIu64 "\n", s->splays);
+  fprintf(f, "rotations per splay %.2f\n",
+          s->rotations/(s->splays ? (double)s->splays : 1.0));
+  fprintf(f, "unflips %" PRIu64 "\n", s->unflips);
+  fprintf(f, "cycles %" PRIu64 ", mean size %.2f\n", s->cycleNr,
+          s->cycleSum/(s->cycleNr ? (double)s->cycleNr : 1.0));
+  i = 0;
+  while (i < LCT_HIST) {
+    if (0 != s->cycles[i])
+      fprintf(f, "  [%" PRIu64 ", %" PRIu64 "[ %" PRIu64 "\n",
+              (uint64_t)1 << i, (uint64_t)1 << (i+1), s->cycles[i]);
+    i++;
+  }
+#else
+  fprintf(f, "No statistics, compile linkCutTree.c with -D LCT_STATS\n");
+#endif /* LCT_STATS */
+}
+
+size_t
+sizeofLCT(LCT t
+          )
+{
+  return bytesLCT(vertexNr(t));
+}
+
+uint32_t
+layoutLCT(void
+          )
+{
+  uint32_t l;
+
+  l = LCT_AUX | LCT_AGG << 4 | LCT_EAGER << 8;
+#ifdef LCT_SOA
+  l |= 1 << 9;
+#endif /* LCT_SOA */
+#ifdef LCT_STATS
+  l |= 1 << 10;
+#endif /* LCT_STATS */
+
+  return l;
 }
 
 void
 freeLCT(LCT t)
 {
-  free(t);
+  assert(NULL == LOG(t) && "Free the snapshots first");
+  free(STACK(t));
+  hugeFree(&((struct LCTHead*)t)[-1]);
 }
 
 void
@@ -457,19 +1796,14 @@ displayRepTree(LCT t,
 {
   int V;
   int i;
-  int p;
 
   V = vertexNr(t);
 
-  i = 1;
-  while(i <= V)
+  i = V + 1;
+  while(i < 2*V)
     {
-      if (0 != successor(t, i))
-        fprintf(f, "%d %d\n", i, successor(t, i));
-      if (auxRootQ(&t[i]) && NULL != t[i].hook) {
-        p = auxParent(t, &t[i]);
-        fprintf(f, "%d %d\n", selectAux(t, i, 1), p);
-      }
+      if (0 != EDGE(t, i).u)
+        fprintf(f, "%d %d\n", EDGE(t, i).u, EDGE(t, i).v);
       i++;
     }
   fprintf(f, "\n");
@@ -480,20 +1814,7 @@ access(LCT t,
        int v
        )
 {
-  int w;
-
-  splay(t, v);
-  setLower(&t[v], NULL);
-
-  while(NULL != t[v].hook) {
-    w = auxParent(t, &t[v]);
-    splay(t, w);
-    setLower(&t[w], &t[v]);
-    splay(t, v);
-  }
-
-  assert(flippedQ(&t[v]) || (NULL == t[v].right && "Failed access invariant."));
-  assert(!flippedQ(&t[v]) || (NULL == t[v].left && "Failed access invariant."));
+  expose(t, v);
 }
 
 void
@@ -502,7 +1823,7 @@ reRoot(LCT t,
        )
 {
   access(t, v);
-  flip(&t[v]);
+  flip(t, rootAux(t, v));
   access(t, v);
 
 }
@@ -513,26 +1834,36 @@ linkedQ(LCT t,
        int v
        )
 {
+#ifdef LCT_ROOTED
+  int r;
+
+  access(t, u);
+  r = selectNode(t, u, 1);
+  access(t, v);
+  return selectNode(t, v, 1) == r;
+#else
   cycle(t, u, v);
-  return selectAux(t, v, 1) == u;
+  return selectNode(t, v, 1) == u;
+#endif /* LCT_ROOTED */
 }
 
 void
 link(LCT t,
      int r,
-     int v
+     int v,
+     int id
      )
 {
-  /* sprintf(sstat, "tree%.4d_Before_Link_%d_%d_dot", ct++, r, v); */
+  int x;
+
   /* showRepTree(t, NULL); */
 
   assert(r != v && "Cutting no edge");
   assert(!linkedQ(t, r, v) && "Link failed. Trees already linked.");
-  reRoot(t, r);
-  access(t, v);
-  setLower(&t[v], &t[r]);
+  x = newEdge(t, r, v, id);
+  hang(t, x, v);
+  hang(t, r, x);
 
-  /* sprintf(sstat, "tree%.4d_After_Link_%d_%d_dot", ct++, r, v); */
   /* showRepTree(t, NULL); */
 
 }
@@ -543,9 +1874,22 @@ cycle(LCT t,
       int v
       )
 {
+  int c;
+#ifdef LCT_ROOTED
+  int du;
+  int dv;
+  int dl;
+
+  pathLca(t, u, v, &du, &dv, &dl);
+  c = (du + dv - 2*dl)/2 + 1;
+#else
   reRoot(t, u);
   access(t, v);
-  return sizeAux(&t[v]);
+  c = sizePath(t, v);
+#endif /* LCT_ROOTED */
+  COUNT_CYCLE(t, c);
+
+  return c;
 }
 
 int
@@ -553,8 +1897,7 @@ sizePath(LCT t /**< [in] */,
       int u /**< [in] */
       )
 {
-  splay(t, u);
-  return sizeAux(&t[u]);
+  return (sizeNodes(t, u) + 1)/2; /* Edge nodes sit between vertexes */
 }
 
 int
@@ -562,15 +1905,7 @@ position(LCT t,
          int v
          )
 {
-  int r;
-  r = 1;
-
-  splay(t, v);
-  unflip(&t[v]);
-  if (NULL != t[v].left)
-    r += sizeAux(t[v].left);
-
-  return r;
+  return (positionNode(t, v) + 1)/2;
 }
 
 int
@@ -579,30 +1914,7 @@ selectAux(LCT t /**< [in] */,
           int i /**< [in] The index of the edge, starting at 1 */
           )
 {
-  int r;
-  LCTAux s;
-  r = 0; /* Default for out of bounds */
-
-  splay(t, v);
-  s = &t[v];
-  if (0 < i && sizeAux(s) >= i) {
-    i--; /* Converted to how many elements do you need on the left */
-    unflip(s);
-    while (sizeAux(s->left) != i) {
-      if (sizeAux(s->left) > i)
-        s = s->left;
-      else {
-        i -= sizeAux(s);
-        s = s->right;
-        i += sizeAux(s);
-      }
-      unflip(s);
-    }
-    r = (int) (s-t);
-    splay(t, r);
-  }
-
-  return r;
+  return 0 < i ? selectNode(t, v, 2*i - 1) : 0;
 }
 
 int
@@ -610,9 +1922,7 @@ successor(LCT t,
           int v
           )
 {
-  splay(t, v);
-  unflip(&t[v]);
-  return selectAux(t, v, 2 + sizeAux(t[v].left));
+  return selectNode(t, v, 2 + positionNode(t, v));
 }
 
 int
@@ -620,9 +1930,10 @@ predecessor(LCT t,
             int v
             )
 {
-  splay(t, v);
-  unflip(&t[v]);
-  return selectAux(t, v, sizeAux(t[v].left));
+  int i;
+
+  i = positionNode(t, v) - 2;
+  return 0 < i ? selectNode(t, v, i) : 0;
 }
 
 int
@@ -634,17 +1945,14 @@ edgeQ(LCT t,
   int r;
 
   r = 0;
+#ifdef LCT_ROOTED
   if (u != v)
-    {
-      cycle(t, u, v);
-      unflip(&t[v]);
-      if(t[v].left == &t[u]){
-      	unflip(t[v].left);
-      	r = (NULL == t[v].left->right);
-      }
+    r = (parentOf(t, u) == v || parentOf(t, v) == u);
+#else
+  if (u != v && 2 == cycle(t, u, v)) /* The path is u, edge node, v */
+    r = (selectNode(t, v, 1) == u);
+#endif /* LCT_ROOTED */
 
-      /* r = (predecessor(t, v) == u); */
-    }
   return r;
 }
 
@@ -658,44 +1966,398 @@ edgeQAux(LCT t,
   int r;
   r = 0;
 
-  splay(t, s);
-
   if (successor(t, u) == v)
     r = 1;
   else if (predecessor(t, u) == v)
     r = 1;
 
-  if(1 == r && s != u && s != v)
-    r = !auxRootQ(&t[s]);
+  if(1 == r) { /* s must be on the same aux tree */
+    while (0 == auxRootQ(t, s))
+      s = PARENT(t, s);
+    while (0 == auxRootQ(t, u))
+      u = PARENT(t, u);
+    r = (s == u);
+  }
 
   return r;
 }
 
-void
+int
 cut(LCT t,
     int u,
     int v
     )
 {
-  /* sprintf(sstat, "tree%.4d_Before_Cut_%d_%d_dot", ct++, u, v); */
+  int r;
+
   /* showRepTree(t, NULL); */
 
   assert(u != v && "Cutting no edge");
   assert(edgeQ(t, u, v) && "Cutting edges that are not there");
 
-  if(1 == edgeQ(t, u, v)) {
-    cycle(t, u, v);
-    unflip(&t[v]);
-    assert(NULL != t[v].left && "Cut guard.");
+  r = -1;
+#ifdef LCT_ROOTED
+  if (parentOf(t, v) == u)
+    r = cutParent(t, v);
+  else if (parentOf(t, u) == v)
+    r = cutParent(t, u);
+#else
+  if(1 == edgeQ(t, u, v)) { /* The path is u x v */
+    r = removeEdge(t, u, selectNode(t, v, 2), v);
+
+    assert(1 == sizeNodes(t, u) && "Size order");
+    assert(1 == sizeNodes(t, v) && "Size order");
+  }
+#endif /* LCT_ROOTED */
+
+  return r;
+}
+
+void
+pathEdge(LCT t,
+         int u,
+         int v,
+         int k,
+         int* a,
+         int* b
+         )
+{
+#ifdef LCT_ROOTED
+  int du;
+  int dv;
+  int dl;
+
+  pathLca(t, u, v, &du, &dv, &dl);
+  selectPath(t, u, v, k, du, dl, a, b);
+#else
+  /* cycle left the path from u to v in one aux tree */
+  *a = selectNode(t, u, 2*k - 1);
+  *b = selectNode(t, u, 2*k + 1);
+#endif /* LCT_ROOTED */
+}
+
+int
+swapEdge(LCT t,
+         int u,
+         int v,
+         int id,
+         uint32_t (*uniform)(void*, uint32_t),
+         void* state,
+         int* a,
+         int* b
+         )
+{
+  int k;
+  int du;
+  int dl;
+#ifdef LCT_ROOTED
+  int dv;
+#endif /* LCT_ROOTED */
+
+  assert(u != v && "Swapping no edge");
+  assert(linkedQ(t, u, v) && "Swap failed. Trees not linked.");
+
+#ifdef LCT_ROOTED
+  pathLca(t, u, v, &du, &dv, &dl);
+  k = (du + dv - 2*dl)/2 + 1;
+#else
+  du = dl = 0;
+  reRoot(t, u);
+  access(t, v); /* The aux tree of v is the path from u to v */
+  k = sizePath(t, v);
+#endif /* LCT_ROOTED */
+  COUNT_CYCLE(t, k);
+  k = 1 + uniform(state, k - 1);
+
+  return replaceEdge(t, u, v, id, 1, k, du, dl, a, b);
+}
+
+int
+weightedSwap(LCT t,
+             int u,
+             int v,
+             int id,
+             LCTWeight w,
+             double x,
+             int* a,
+             int* b
+             )
+{
+  int k;
+  int du;
+  int dl;
+#ifdef LCT_ROOTED
+  int dv;
+#endif /* LCT_ROOTED */
+#if LCT_AGG_SUM == LCT_AGG
+  LCTWeight r;
+  LCTWeight su; /* Weight on the side of u */
+  LCTWeight sv; /* Weight on the side of v */
+#ifdef LCT_ROOTED
+  int l;
+  int pu; /* Aux tree of the side of u, below l */
+  int pv; /* Aux tree of the side of v, below l */
+#endif /* LCT_ROOTED */
+#else
+  int r;
+#endif /* LCT_AGG_SUM */
+
+  assert(u != v && "Swapping no edge");
+  assert(linkedQ(t, u, v) && "Swap failed. Trees not linked.");
+  assert(0 <= x && x < 1 && "Position out of range");
+
+  *a = *b = 0;
+  du = dl = 0;
+#ifdef LCT_ROOTED
+#if LCT_AGG_SUM == LCT_AGG
+  l =
+#endif /* LCT_AGG_SUM */
+  pathLca(t, u, v, &du, &dv, &dl);
+  k = (du + dv - 2*dl)/2 + 1;
+#else
+  reRoot(t, u);
+  access(t, v); /* The aux tree of v is the path from u to v */
+  k = sizePath(t, v);
+#endif /* LCT_ROOTED */
+  COUNT_CYCLE(t, k);
+
+#if LCT_AGG_SUM == LCT_AGG
+#ifdef LCT_ROOTED
+  su = sv = 0;
+  pu = pv = 0;
+  if (l != v) { /* Read the side of v, then the side of u */
+    spliceAux(t, l, 0);
+    pv = rootAux(t, v);
+    sv = AGG(t, pv).sum;
+  }
+  access(t, u);
+  if (l != u) {
+    spliceAux(t, l, 0);
+    pu = rootAux(t, u);
+    su = AGG(t, pu).sum;
+  }
+#else
+  su = 0;
+  sv = AGG(t, rootAux(t, v)).sum;
+#endif /* LCT_ROOTED */
+
+  r = x*(su + sv + w);
+  if (r < su + sv) {
+#ifdef LCT_ROOTED
+    if (r < su) { /* Counted from u, going up */
+      k = selectWeight(t, pu, r);
+      k = (du - dl - positionNode(t, k))/2 + 1;
+    } else {
+      k = selectWeight(t, pv, r - su);
+      k = (du - dl)/2 + (positionNode(t, k) + 1)/2;
+    }
+    access(t, v);
+#else
+    k = positionNode(t, selectWeight(t, rootAux(t, v), r))/2;
+#endif /* LCT_ROOTED */
+    k = replaceEdge(t, u, v, id, w, k, du, dl, a, b);
+  } else
+    k = -1; /* The new edge was drawn, nothing changes */
+#else
+  r = (int)(x*k); /* Every edge weighs 1, the new edge is k-1 */
+  if (r < k - 1)
+    k = replaceEdge(t, u, v, id, w, r + 1, du, dl, a, b);
+  else
+    k = -1;
+#endif /* LCT_AGG_SUM */
+
+  return k;
+}
+
+void
+setWeight(LCT t,
+          int u,
+          int v,
+          LCTWeight w
+          )
+{
+  assert(edgeQ(t, u, v) && "Weighting edges that are not there");
+
+#if LCT_AGG_SIZE != LCT_AGG
+  u = edgeNode(t, u, v);
+  logEdge(t, u);
+  AGG(t, u).w = w;
+  pullUp(t, u);
+#endif /* LCT_AGG */
+}
+
+LCTWeight
+weightOf(LCT t,
+         int u,
+         int v
+         )
+{
+  assert(edgeQ(t, u, v) && "Weighting edges that are not there");
+
+#if LCT_AGG_SIZE != LCT_AGG
+  return AGG(t, edgeNode(t, u, v)).w;
+#else
+  return 1;
+#endif /* LCT_AGG */
+}
+
+void
+pathAggregate(LCT t,
+              int u,
+              int v,
+              struct LCTPath* p
+              )
+{
+#ifdef LCT_ROOTED
+  int du;
+  int dv;
+  int dl;
+  int l;
+#endif /* LCT_ROOTED */
+
+  p->sum = 0;
+  p->min = 0;
+  p->max = 0;
+#if LCT_AGG_MINMAX == LCT_AGG
+  p->min = HUGE_VAL;
+  p->max = -HUGE_VAL;
+#endif /* LCT_AGG_MINMAX */
+
+#ifdef LCT_ROOTED
+  l = pathLca(t, u, v, &du, &dv, &dl);
+  p->edges = (du + dv - 2*dl)/2;
+  if (l != v) { /* From below l to v */
+    spliceAux(t, l, 0);
+    addPath(t, rootAux(t, v), p);
+  }
+  access(t, u);
+  if (l != u) { /* From below l to u */
+    spliceAux(t, l, 0);
+    addPath(t, rootAux(t, u), p);
+  }
+#else
+  p->edges = cycle(t, u, v) - 1;
+  addPath(t, rootAux(t, v), p);
+#endif /* LCT_ROOTED */
+
+  if (LCT_AGG_SIZE == LCT_AGG) { /* Every edge weighs 1 */
+    p->sum = p->edges;
+    p->min = 1;
+    p->max = 1;
+  }
+}
+
+LCTSnap
+snapshotLCT(LCT t
+            )
+{
+  LCTSnap s;
+
+  if (NULL == LOG(t)) {
+    LOG(t) = (struct LCTLog*) malloc(sizeof(struct LCTLog));
+    LOG(t)->U = NULL;
+    LOG(t)->n = 0;
+    LOG(t)->size = 0;
+    LOG(t)->snaps = 0;
+    pthread_mutex_init(&LOG(t)->lock, NULL);
+  }
+  LOG(t)->snaps++;
+
+  s = (LCTSnap) malloc(sizeof(struct LCTSnap));
+  s->t = t;
+  s->n = LOG(t)->n;
+
+  return s;
+}
+
+void
+freeSnapshot(LCTSnap s
+             )
+{
+  LCT t;
+
+  t = s->t;
+  LOG(t)->snaps--;
+  if (0 == LOG(t)->snaps) { /* Stop logging */
+    pthread_mutex_destroy(&LOG(t)->lock);
+    free(LOG(t)->U);
+    free(LOG(t));
+    LOG(t) = NULL;
+  }
+  free(s);
+}
 
-    t[v].sum -= sizeAux(t[v].left);
+void
+displaySnapshot(LCTSnap s,
+                FILE *f
+                )
+{
+  LCT t;
+  struct LCTLog* L;
+  int32_t (*B)[2]; /* Endpoints of each edge node at s, reader scratch */
+  size_t i;
+  int x;
+  int V;
 
-    assert(0 != t[v].sum && "Size set to 0");
+  t = s->t;
+  L = LOG(t);
+  V = vertexNr(t);
+  B = (int32_t (*)[2]) malloc(V*sizeof(*B));
+
+  /* Copy the edges first and then patch the ones logged after s, the
+     oldest entry last. An edge is logged before it changes, so one that
+     is not in the log yet was copied before any change after s. */
+  x = V + 1;
+  while (x < 2*V) {
+    B[x - V][0] = EDGE(t, x).u;
+    B[x - V][1] = EDGE(t, x).v;
+    x++;
+  }
+  pthread_mutex_lock(&L->lock);
+  assert(s->n <= L->n && "Snapshot taken after a restore");
+  i = L->n;
+  while (s->n < i) {
+    i--;
+    B[L->U[i].x - V][0] = L->U[i].u;
+    B[L->U[i].x - V][1] = L->U[i].v;
+  }
+  pthread_mutex_unlock(&L->lock);
 
-    t[v].left->hook = NULL;
-    t[v].left = NULL;
+  x = 1;
+  while (x < V) {
+    if (0 != B[x][0])
+      fprintf(f, "%d %d\n", B[x][0], B[x][1]);
+    x++;
+  }
+  fprintf(f, "\n");
+  free(B);
+}
 
-    assert(sizeAux(&t[v]) > sizeAux(t[v].right) && "Size order");
-    assert(sizeAux(&t[v]) > sizeAux(t[v].left) && "Size order");
+void
+restoreLCT(LCTSnap s
+           )
+{
+  LCT t;
+  struct LCTLog* L;
+  struct undo* e;
+
+  t = s->t;
+  L = LOG(t);
+  assert(s->n <= L->n && "Snapshot taken after a restore");
+
+  LOG(t) = NULL; /* Undoing is not logged */
+  while (s->n < L->n) {
+    L->n--;
+    e = &L->U[L->n];
+    if (0 == e->u) /* x was linked */
+      cut(t, EDGE(t, e->x).u, EDGE(t, e->x).v);
+    else {
+      if (0 == EDGE(t, e->x).u) { /* x was cut */
+        link(t, e->u, e->v, e->id);
+        assert(e->u == EDGE(t, e->x).u && "Free list out of order");
+      }
+      setWeight(t, e->u, e->v, e->w);
+    }
   }
+  LOG(t) = L;
 }
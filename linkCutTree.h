@@ -31,9 +31,45 @@
 #define LINKCUTTREE_H
 
 #include <stdio.h>
+#include <stdint.h>
 
 typedef struct LCT* LCT; /** Link-Cut tree abstract data type. */
 
+typedef struct LCTSnap* LCTSnap; /** Snapshot of the edges of an LCT. */
+
+/** Number of buckets of the cycle histogram. Bucket i counts the sizes in
+    [2^i, 2^(i+1)[. */
+#define LCT_HIST 32
+
+/** Operation counters. They are only updated when linkCutTree.c is
+    compiled with -D LCT_STATS, otherwise the counting compiles to
+    nothing. */
+struct LCTStats {
+  uint64_t rotations; /** Single rotations in the aux trees */
+  uint64_t splays; /** Calls to splay */
+  uint64_t unflips; /** Flip bits pushed down to the children */
+  uint64_t accesses; /** Calls to access */
+  uint64_t changes; /** Preferred path changes in access */
+  uint64_t length; /** Sum of the path sizes exposed by access */
+  uint64_t cycleNr; /** Number of cycles measured */
+  uint64_t cycleSum; /** Sum of the cycle sizes */
+  uint64_t cycles[LCT_HIST]; /** Histogram of the cycle sizes */
+};
+
+/** Weight of an edge. The aggregate kept over paths is chosen when
+    compiling linkCutTree.c, see LCT_AGG there. */
+typedef double LCTWeight;
+
+/** Aggregate of the edge weights on a path. The fields that the build does
+    not keep are 0. With the default LCT_AGG_SIZE every edge weighs 1, so
+    all of them are given. */
+struct LCTPath {
+  int edges; /** Number of edges */
+  LCTWeight sum; /** Sum of the weights, kept with LCT_AGG_SUM */
+  LCTWeight min; /** Smallest weight, kept with LCT_AGG_MINMAX */
+  LCTWeight max; /** Largest weight, kept with LCT_AGG_MINMAX */
+};
+
 /** @return Empty LCT, over vertexes labelled 1 to V */
 LCT
 allocLCT(int V /**< [in] Number of vertexes of the underlying graph */
@@ -49,6 +85,55 @@ LCT
 clone(LCT t /** [in] Original tree. */
       );
 
+/** @return The number of bytes of t. An LCT is one block, holding indexes
+    and no pointers, so these bytes can be written to a file and read, or
+    mapped, back as they are. The snapshot log and the scratch stack are
+    kept out of it. */
+size_t
+sizeofLCT(LCT t /** [in] */
+          );
+
+/** @return The build flags that change the meaning of the block of
+    sizeofLCT, LCT_AUX, LCT_AGG, LCT_ROOTED, LCT_SOA and LCT_STATS, packed
+    in a word. Blocks of builds that differ here can not be exchanged,
+    even when they have the same size. */
+uint32_t
+layoutLCT(void
+          );
+
+/** @return A snapshot of the edges of t, and their weights, taken in
+    O(1). While t has snapshots its changes log the previous state of the
+    edges they touch, so a snapshot costs space and time proportional to
+    the changes made after it. The root and the aux trees are not kept.
+    IMPORTANT: cleanLCT, array2LCT and freeLCT need t without snapshots,
+    and the block of sizeofLCT does not hold them. */
+LCTSnap
+snapshotLCT(LCT t /**< [in] */
+            );
+
+/** Free the snapshot, the tree stops logging with its last one. */
+void
+freeSnapshot(LCTSnap s /**< [in] */
+             );
+
+/** Prints the edges of the snapshot, as displayRepTree, in O(V) plus the
+    changes made after it. The tree is not changed and the scratch space
+    is the caller's, so other threads may call this while the thread that
+    owns the tree keeps changing it. The other functions on snapshots, and
+    restoreLCT, must be called by that thread. */
+void
+displaySnapshot(LCTSnap s /**< [in] */,
+                FILE *f /**< [in] */
+                );
+
+/** Undoes the changes made to the tree of s after s was taken, in time
+    proportional to them. The edges return to the same edge nodes, so
+    older snapshots stay valid. Snapshots taken after s must only be
+    freed. */
+void
+restoreLCT(LCTSnap s /**< [in] */
+           );
+
 /** Make an LCT from array info */
 void
 array2LCT(int v /** [in] number of vertexes */,
@@ -56,6 +141,25 @@ array2LCT(int v /** [in] number of vertexes */,
 	  LCT O /** [in] original tree to keep hash values */
 	  );
 
+/** Stores the tree in A, as in array2LCT: A[i] is the parent of vertex i,
+    0 for roots. The aux trees are walked in order, in O(V), and are not
+    changed, neither are the lazy flips pushed down. */
+void
+LCT2array(LCT t /**< [in] */,
+          int* A /**< [out] Indexed 1 to V */
+          );
+
+/** Adds the edges (i, parent[i]) to an LCT without edges, in O(V). Each
+    aux tree starts with a single node, so later accesses pay for
+    building the preferred paths.
+    IMPORTANT: parent must describe a forest, parent[i] <= 0 for roots. */
+void
+buildLCT(LCT t /**< [in] */,
+         int* parent /**< [in] Indexed 1 to V */,
+         int* id /**< [in] Edge identifiers, as parent. -1 for all if
+                    NULL */
+         );
+
 /** Free the LCT */
 void
 freeLCT(LCT t /** [in] */
@@ -71,6 +175,26 @@ int
 vertexNr(LCT t
          );
 
+/** Starts loading the node of v into the cache, without waiting. */
+void
+prefetchLCT(LCT t /**< [in] */,
+            int v /**< [in] Node */
+            );
+
+/** @return The parent of node v, in its aux tree or across aux trees, 0
+    at the root. Access from v goes up this chain, so prefetching it hides
+    the cost of the first misses. Reads the node of v. */
+int
+aboveLCT(LCT t /**< [in] */,
+         int v /**< [in] Node */
+         );
+
+/** Prints a summary of the operation counters of t. */
+void
+statsLCT(LCT t /** [in] */,
+         FILE *f /** [in] */
+         );
+
 /** Contain the path from root to v in a splay tree. */
 void
 access(LCT t /**< [in] */,
@@ -97,7 +221,8 @@ linkedQ(LCT t /**< [in] */,
 void
 link(LCT t /**< [in] */,
      int r /**< [in] Becomes the root of its sub-tree, before linking. */,
-     int v /**< [in] */
+     int v /**< [in] */,
+     int id /**< [in] Edge identifier, returned by cut and swapEdge */
      );
 
 /** Contains the cycle between u and v in a splay tree. IMPORANT: this is
@@ -105,7 +230,9 @@ link(LCT t /**< [in] */,
     inconsistent.
 
     In general this function could be called pathify. I use only on cycles,
-    but coding is general.
+    but coding is general. With LCT_ROOTED the root does not change, the
+    path is found from the lowest common ancestor and is not left in one
+    aux tree.
 
     @return the size of the resulting cycle. Number of vertexes involved. */
 int
@@ -115,6 +242,9 @@ cycle(LCT t /**< [in] */,
       );
 
 /** Obtains the size of an existing path, where a certain vertex exists.
+    Edges are nodes of the aux trees, placed between their endpoints, so
+    this, position and selectAux only count vertexes on paths that start
+    at a vertex, such as the ones left by access.
 
     @return the size of the existing path.
  */
@@ -168,12 +298,94 @@ edgeQAux(LCT t /**< [in] */,
          int v /**< [in] */
          );
 
-/** Remove the edge (u,v) from the LCT, from whatever aux tree that
-    contains it. Does nothing if edge is not there. */
+/** Obtains the k-th edge on the path from u to v, *a is the endpoint
+    closer to u.
+    IMPORTANT: Call right after cycle(t, u, v), with 1 <= k and k smaller
+    than its result. */
 void
+pathEdge(LCT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */,
+         int k /**< [in] */,
+         int* a /**< [out] */,
+         int* b /**< [out] */
+         );
+
+/** Remove the edge (u,v) from the LCT, from whatever aux tree that
+    contains it. Does nothing if edge is not there.
+
+    @return The id given to link, -1 if the edge is not there. */
+int
 cut(LCT t /**< [in] */,
     int u /**< [in] Becomes the root of its sub-tree. */,
     int v /**< [in] */
     );
 
+/** Replaces one edge of the path from u to v by the edge (u, v). The path
+    is exposed once, the removed edge is the k-th one from u, with k drawn
+    as 1 + uniform(path edges), and the edge is cut and the new one linked
+    on that same path.
+    IMPORTANT: u and v must be linked, but not adjacent.
+
+    @return The id of the removed edge. */
+int
+swapEdge(LCT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */,
+         int id /**< [in] Identifier of the new edge (u, v) */,
+         uint32_t (*uniform)(void*, uint32_t) /**< [in] Uniform value in
+                                                 [0, n[ */,
+         void* state /**< [in/out] First argument of uniform */,
+         int* a /**< [out] Removed edge, endpoint closer to u */,
+         int* b /**< [out] Removed edge */
+         );
+
+/** Replaces one edge of the cycle formed by the path from u to v and the
+    new edge (u, v), with weight w, by the edge (u, v). Each edge is drawn
+    with probability proportional to its weight, by position x in the
+    cumulative weight of the cycle. When the new edge is drawn nothing
+    changes. Weights are summed with LCT_AGG_SUM, otherwise every edge
+    counts 1.
+    IMPORTANT: u and v must be linked, but not adjacent.
+
+    @return The id of the removed edge, -1 if the new edge was drawn. */
+int
+weightedSwap(LCT t /**< [in] */,
+             int u /**< [in] */,
+             int v /**< [in] */,
+             int id /**< [in] Identifier of the new edge (u, v) */,
+             LCTWeight w /**< [in] Weight of the new edge */,
+             double x /**< [in] Uniform position, in [0, 1[ */,
+             int* a /**< [out] Removed edge, endpoint closer to u */,
+             int* b /**< [out] Removed edge */
+             );
+
+/** Sets the weight of the edge (u, v). Edges weigh 1 when linked. Does
+    nothing with LCT_AGG_SIZE.
+    IMPORTANT: edgeQ(t, u, v) must be true. */
+void
+setWeight(LCT t /**< [in] */,
+          int u /**< [in] */,
+          int v /**< [in] */,
+          LCTWeight w /**< [in] */
+          );
+
+/** @return The weight of the edge (u, v).
+    IMPORTANT: edgeQ(t, u, v) must be true. */
+LCTWeight
+weightOf(LCT t /**< [in] */,
+         int u /**< [in] */,
+         int v /**< [in] */
+         );
+
+/** Obtains the aggregate of the weights on the path from u to v. With
+    LCT_AGG_MINMAX and no edges min and max are HUGE_VAL and -HUGE_VAL.
+    IMPORTANT: linkedQ(t, u, v) must be true. */
+void
+pathAggregate(LCT t /**< [in] */,
+              int u /**< [in] */,
+              int v /**< [in] */,
+              struct LCTPath* p /**< [out] */
+              );
+
 #endif /* LINKCUTTREE_H */
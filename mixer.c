@@ -31,23 +31,64 @@
 #include <limits.h>
 #include <string.h>
 #include <sys/param.h>
-#include <bsd/stdlib.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #include "mixer.h"
 
 /* #warning "TODO: Mark with this." */
 /*** typedefs(not structures) and defined constants *******/
 
+/* Steps that each chain of mixInterleaved keeps drawn, the one it
+   executes included. Each is one stage further in loading what it needs,
+   the older ones climb one node per round towards the root. */
+#define LANE 16
+
 /*** enums ************************************************/
 
 /*** structure declarations *******************************/
 
 struct sample {
-  LCT A; /** The LinkCut Tree */
+  forest A; /** The spanning tree */
   int* P; /** Keeps P mappings for everyone */
   int* Pi; /** Inverse of P */
 };
 
+/** A group of the independent chains of mixChains, run by one thread. */
+struct chain {
+  forest* A; /** The spanning trees */
+  int** P; /** Their edge permutations */
+  graph g; /** The graph, shared by all chains */
+  long long s; /** Number of steps */
+  int K; /** Number of chains in the group, 0 for one without
+             interleaving */
+  struct rng* X; /** Their generators */
+};
+
+/** A chain of mixInterleaved, with the steps it drew ahead. Slot h holds
+    the newest step, the one of age a is in slot (h - a) mod LANE. */
+struct lane {
+  forest A; /** The spanning tree */
+  int* P; /** Its edge permutation */
+  struct rng* X; /** Its generator */
+  int h; /** Newest slot */
+  int j[LANE]; /** Position in P of the inserted edge */
+  int w[LANE][2]; /** Last node prefetched above each endpoint */
+};
+
+/** The writer thread of startWriter, with the snapshot it prints. */
+struct treeWriter {
+  forest A; /** The tree of the chain */
+  FILE* out; /** Output */
+  forestSnap s; /** Last snapshot taken, NULL before the first */
+  int busy; /** 1 while s is not written */
+  int stop; /** Set by stopWriter */
+  pthread_t th; /** The writer */
+  pthread_mutex_t lock; /** Guards busy and stop */
+  pthread_cond_t done; /** Signalled when busy or stop change */
+};
+
 /*** file scope functions declarations (static) ***********/
 
 /* Generates information about one step of the Markov Chain */
@@ -55,9 +96,10 @@ static void
 stepInfo(int* i,
          int* ou,
          int* ov,
-         LCT A,
+         forest A,
          int* P,
-         graph g
+         graph g,
+         struct rng* R
          );
 
 /* Executes one step of the Markov Chain */
@@ -65,7 +107,7 @@ static void
 stepExecute(int i,
             int ou,
             int ov,
-            LCT A,
+            forest A,
             int* P,
             graph g
             );
@@ -81,13 +123,60 @@ pSwap(int* P /** [in] */,
 #ifndef NDEBUG
 /** Verifies if Ex is coerent with the tree */
 static void
-pAssert(LCT A /** [in]  */,
+pAssert(forest A /** [in]  */,
         int* Ex /** [in] */,
         graph g /** [in] */
         );
 #endif /* NDEBUG */
 
-/** Resets the SLP data structure. */
+/** @return rngUniform(R, n), in the form forestSwap takes. */
+static uint32_t
+drawUniform(void* R /** [in/out] struct rng */,
+            uint32_t n /** [in] */
+            );
+
+/** @return The representative of x, halving the path to it. Roots store
+    minus the size of their set. */
+static int
+ufFind(int* U /** [in/out] Union-find array */,
+       int x /** [in] */
+       );
+
+/** Roots each tree of the forest given by the n edges in T at its lowest
+    vertex. Fills the parent of every vertex, 0 for roots, and the index
+    of the edge to it. */
+static void
+rootForest(graph g /** [in] */,
+           int* T /** [in] Edge indexes */,
+           int n /** [in] Number of edges in T */,
+           int* parent /** [out] Indexed 1 to V */,
+           int* id /** [out] Indexed 1 to V */
+           );
+
+/** Thread body, runs one group of chains of mixChains. */
+static void*
+runChain(void* arg /** [in] struct chain */
+         );
+
+/** Thread body of startWriter, prints each snapshot it is given. */
+static void*
+writerWork(void* arg /** [in] struct treeWriter */
+           );
+
+/** Waits until the writer printed the last snapshot, then frees it in
+    the thread of the chain, as freeForestSnap requires. */
+static void
+writerIdle(treeWriter w /** [in/out] */
+           );
+
+/** Executes the step that inserts the edge at position j of P. */
+static void
+stepAt(forest A /** [in/out] */,
+       int* P /** [in/out] Must not be NULL. */,
+       graph g /** [in] */,
+       int j /** [in] Position of a non tree edge */,
+       struct rng* R /** [in/out] */
+       );
 
 /*** declarations of public functions (first inlines) *****/
 
@@ -95,9 +184,10 @@ static void
 stepInfo(int* i,
          int* ou,
          int* ov,
-         LCT A,
+         forest A,
          int* P,
-         graph g
+         graph g,
+         struct rng* R
          )
 {
   int c; /* Cycle size. */
@@ -107,17 +197,17 @@ stepInfo(int* i,
   int iv;  /* Insert vertex */
   int j;
   int e = edgesNr(g);
-  int V = vertexNr(A);
+  int V = forestVertexNr(A);
   E = edges(g);
 
   if (-1 == *i) {
     if (NULL != P) {
-      j = arc4random_uniform(e-(V-1));
+      j = rngUniform(R, e-(V-1));
       j+= (V-1);
       *i = P[j];
-      assert(!edgeQ(A, E[*i][0], E[*i][1]) && "Improper insert.");
+      assert(!forestEdgeQ(A, E[*i][0], E[*i][1]) && "Improper insert.");
     } else
-      *i = arc4random_uniform(e);
+      *i = rngUniform(R, e);
   }
 
   /** Otherwise i is considered input. */
@@ -125,25 +215,20 @@ stepInfo(int* i,
   *ov = 0;
   iu = E[*i][0];
   iv = E[*i][1];
-  if (!edgeQ(A, iu, iv)) {
-    c = cycle(A, iu, iv);
-    idx = arc4random_uniform(c-1)+1;
-    *ou = selectAux(A, iu, idx);
-    *ov = successor(A, *ou);
+  if (!forestEdgeQ(A, iu, iv)) {
+    c = forestCycle(A, iu, iv);
+    idx = rngUniform(R, c-1)+1;
+    forestPathEdge(A, iu, iv, idx, ou, ov);
   }
 
-#ifndef NDEBUG
-  assert(edgeQ(A, *ou, *ov) && "Improper removal.");
-  cycle(A, E[*i][0], E[*i][1]);
-  assert(edgeQAux(A, E[*i][1], *ou, *ov) && "Improper removal.");
-#endif /* NDEBUG */
+  assert(forestEdgeQ(A, *ou, *ov) && "Improper removal.");
 }
 
 static void
 stepExecute(int i,
             int ou,
             int ov,
-            LCT A,
+            forest A,
             int* P,
             graph g
             )
@@ -151,6 +236,7 @@ stepExecute(int i,
   edge* E; /* Edge array */
   int e = edgesNr(g);
   int* Pi = &P[e];
+  int r; /* Removed edge */
 
   /* static int fc=0; */
   /* static char file[20]; */
@@ -162,15 +248,15 @@ stepExecute(int i,
   /* showLCT(A, file); */
 
   E = edges(g);
-  cut(A, ou, ov);
+  r = forestCut(A, ou, ov);
   /* sprintf(file, "cortada%d_dot", fc); */
   /* showRepTree(A, file); */
   /* sprintf(file, "cortadaFull%d_dot", fc); */
   /* showLCT(A, file); */
 
-  link(A, E[i][0], E[i][1]);
+  forestLink(A, E[i][0], E[i][1], i);
   if (NULL != P)
-    pSwap(P, e, Pi[i], Pi[edgeIdx(g, ou, ov)]);
+    pSwap(P, e, Pi[i], Pi[r]);
 
   /* sprintf(file, "ligada%d_dot", fc); */
   /* showRepTree(A, file); */
@@ -202,7 +288,7 @@ pSwap(int* P,
 
 #ifndef NDEBUG
 static void
-pAssert(LCT A,
+pAssert(forest A,
         int* P,
         graph g
         )
@@ -215,18 +301,18 @@ pAssert(LCT A,
 
   if (NULL != P) {
     e = edgesNr(g);
-    V = vertexNr(A);
+    V = forestVertexNr(A);
     E = edges(g);
     Pi = &P[e];
 
     i = 0;
     while (i < V-1) {
-      assert(edgeQ(A, E[P[i]][0], E[P[i]][1]));
+      assert(forestEdgeQ(A, E[P[i]][0], E[P[i]][1]));
       assert(Pi[P[i]] == i);
       i++;
     }
     while (i < e) {
-      assert(!edgeQ(A, E[P[i]][0], E[P[i]][1]));
+      assert(!forestEdgeQ(A, E[P[i]][0], E[P[i]][1]));
       assert(Pi[P[i]] == i);
       i++;
     }
@@ -234,34 +320,239 @@ pAssert(LCT A,
 }
 #endif /* NDEBUG */
 
-LCT
-loadLCT(graph g,
-        int* P
-        )
+static int
+ufFind(int* U,
+       int x
+       )
+{
+  while (0 <= U[x] && 0 <= U[U[x]]) {
+    U[x] = U[U[x]];
+    x = U[x];
+  }
+  if (0 <= U[x])
+    x = U[x];
+
+  return x;
+}
+
+static void
+rootForest(graph g,
+           int* T,
+           int n,
+           int* parent,
+           int* id
+           )
+{
+  int V;
+  edge* E;
+  int* off; /* Adjacency of the tree, by vertex */
+  int* adj;
+  int* Q; /* Queue of the search */
+  int h;
+  int q;
+  int i;
+  int k;
+  int x;
+  int y;
+
+  V = graphVertexNr(g);
+  E = edges(g);
+  off = (int*) calloc(V+2, sizeof(int));
+  adj = (int*) malloc(2*n*sizeof(int));
+  Q = (int*) malloc(V*sizeof(int));
+
+  i = 0;
+  while (i < n) { /* Count degrees */
+    off[E[T[i]][0]+1]++;
+    off[E[T[i]][1]+1]++;
+    i++;
+  }
+  i = 1;
+  while (i <= V+1) {
+    off[i] += off[i-1];
+    i++;
+  }
+  i = 0;
+  while (i < n) { /* After this, x is in [off[x-1], off[x][ */
+    adj[off[E[T[i]][0]]++] = T[i];
+    adj[off[E[T[i]][1]]++] = T[i];
+    i++;
+  }
+
+  i = 1;
+  while (i <= V) {
+    parent[i] = -1; /* Not seen */
+    i++;
+  }
+
+  i = 1;
+  while (i <= V) {
+    if (-1 == parent[i]) { /* Breadth first from a new root */
+      parent[i] = 0;
+      id[i] = -1;
+      h = q = 0;
+      Q[q++] = i;
+      while (h < q) {
+        x = Q[h++];
+        k = off[x-1];
+        while (k < off[x]) {
+          y = E[adj[k]][0] == x ? E[adj[k]][1] : E[adj[k]][0];
+          if (-1 == parent[y]) {
+            parent[y] = x;
+            id[y] = adj[k];
+            Q[q++] = y;
+          }
+          k++;
+        }
+      }
+    }
+    i++;
+  }
+
+  free(Q);
+  free(adj);
+  free(off);
+}
+
+static uint32_t
+drawUniform(void* R,
+            uint32_t n
+            )
+{
+  return rngUniform((struct rng*)R, n);
+}
+
+static void*
+runChain(void* arg
+         )
+{
+  struct chain* c;
+
+  c = (struct chain*)arg;
+  if (0 == c->K)
+    mixFixed(c->A[0], c->P[0], c->g, c->s, c->X);
+  else
+    mixInterleaved(c->A, c->P, c->g, c->s, c->K, c->X);
+
+  return NULL;
+}
+
+static void*
+writerWork(void* arg
+           )
+{
+  treeWriter w;
+  forestSnap s;
+
+  w = (treeWriter)arg;
+  pthread_mutex_lock(&w->lock);
+  while (w->busy || !w->stop) {
+    if (!w->busy)
+      pthread_cond_wait(&w->done, &w->lock);
+    else {
+      s = w->s;
+      pthread_mutex_unlock(&w->lock);
+      displayForestSnap(s, w->out);
+      pthread_mutex_lock(&w->lock);
+      w->busy = 0;
+      pthread_cond_broadcast(&w->done);
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  return NULL;
+}
+
+static void
+writerIdle(treeWriter w
+           )
+{
+  pthread_mutex_lock(&w->lock);
+  while (w->busy)
+    pthread_cond_wait(&w->done, &w->lock);
+  pthread_mutex_unlock(&w->lock);
+
+  if (NULL != w->s)
+    freeForestSnap(w->s);
+  w->s = NULL;
+}
+
+static void
+stepAt(forest A,
+       int* P,
+       graph g,
+       int j,
+       struct rng* R
+       )
+{
+  int i;
+  int ou;
+  int ov;
+  int e;
+  edge* E;
+
+  e = edgesNr(g);
+  E = edges(g);
+  i = P[j];
+  i = forestSwap(A, E[i][0], E[i][1], i, drawUniform, R, &ou, &ov);
+  pSwap(P, e, j, P[e + i]); /* The forest tells the removed edge */
+}
+
+void
+initialTree(graph g,
+            int* P,
+            int* parent,
+            int* id
+            )
 {
-  LCT t;
   int V;
   int e;
   edge* E;
   int i;
   int* Pi;
   int j;
+  int n; /* Tree edges */
+  int* U; /* Union-find, then parents */
+  int* T; /* Tree edges, then edge to the parent */
+  int ru;
+  int rv;
+  int x; /* Temporary for swaps */
 
   V = graphVertexNr(g);
   E = edges(g);
   e = edgesNr(g);
-  t = allocLCT(V);
-  Pi = &P[e];
+  Pi = NULL != P ? &P[e] : NULL;
+  U = parent;
+  T = id;
 
+  i = 0;
+  while (i <= V) {
+    U[i] = -1;
+    i++;
+  }
+
+  /* The same tree as linking the edges in order, found with union-find */
+  n = 0;
   j = V-1;
   i = 0;
-  while(i < e && (NULL != P || V > 1)) {
-    if (!linkedQ(t, E[i][0], E[i][1])) {
-      link(t, E[i][0], E[i][1]);
-      V--;
-      P[V-1] = i;
-      Pi[P[V-1]] = V-1;
-    } else {
+  while(i < e && (NULL != P || n < V-1)) {
+    ru = ufFind(U, E[i][0]);
+    rv = ufFind(U, E[i][1]);
+    if (ru != rv) {
+      if (U[ru] > U[rv]) { /* Union by size, ru is the larger set */
+        x = ru;
+        ru = rv;
+        rv = x;
+      }
+      U[ru] += U[rv];
+      U[rv] = ru;
+      T[n] = i;
+      n++;
+      if (NULL != P) {
+        P[V-1-n] = i;
+        Pi[i] = V-1-n;
+      }
+    } else if (NULL != P) {
       P[j] = i;
       Pi[P[j]] = j;
       j++;
@@ -269,6 +560,36 @@ loadLCT(graph g,
     i++;
   }
 
+  rootForest(g, T, n, U, T); /* T is read before the ids are written */
+}
+
+forest
+loadForest(graph g,
+           int* P,
+           forestKind k
+           )
+{
+  forest t;
+  int V;
+  int* parent;
+  int* id;
+  int* Q; /* Permutation of the graph file */
+
+  V = graphVertexNr(g);
+  t = allocForest(k, V);
+  if (graphTree(g, &parent, &id, &Q)) { /* Computed by the converter */
+    if (NULL != P)
+      memcpy(P, Q, 2*edgesNr(g)*sizeof(int));
+    forestBuild(t, parent, id);
+  } else {
+    parent = (int*) malloc((V+1)*sizeof(int));
+    id = (int*) malloc((V+1)*sizeof(int));
+    initialTree(g, P, parent, id);
+    forestBuild(t, parent, id);
+    free(id);
+    free(parent);
+  }
+
 #ifndef NDEBUG
   pAssert(t, P, g);
 #endif /* NDEBUG */
@@ -276,34 +597,297 @@ loadLCT(graph g,
 }
 
 void
-step(LCT A,
+step(forest A,
      int* P,
-     graph g
+     graph g,
+     struct rng* R
      )
 {
   int i;
+  int j;
   int ou;
   int ov;
+  int e;
+  int V;
 
-  i = -1;
-  stepInfo(&i, &ou, &ov, A, P, g);
-  if (0 != ou && 0 != ov)
-    stepExecute(i, ou, ov, A, P, g);
+  if (NULL != P) { /* P tells the tree edges, the swap is fused */
+    e = edgesNr(g);
+    V = forestVertexNr(A);
+    j = rngUniform(R, e-(V-1));
+    j += (V-1);
+    stepAt(A, P, g, j, R);
+  } else {
+    i = -1;
+    stepInfo(&i, &ou, &ov, A, P, g, R);
+    if (0 != ou && 0 != ov)
+      stepExecute(i, ou, ov, A, P, g);
+  }
 }
 
 void
-mixFixed(LCT A,
+mixFixed(forest A,
          int* P,
          graph g,
-         int s
+         long long s,
+         struct rng* R
          )
 {
   while (0 < s){
-    step(A, P, g);
+    step(A, P, g, R);
+    s--;
+  }
+}
+
+void
+mixChains(forest* A,
+          int** P,
+          graph g,
+          long long s,
+          int J,
+          int K,
+          struct rng* X
+          )
+{
+  struct chain* C;
+  pthread_t* th;
+  int T; /* Threads, one per group of K chains */
+  int n; /* Chains per group */
+  int j;
+
+  n = MAX(K, 1);
+  T = (J + n - 1)/n;
+  C = (struct chain*) malloc(T*sizeof(struct chain));
+  th = (pthread_t*) malloc(T*sizeof(pthread_t));
+  j = 0;
+  while (j < T) {
+    C[j].A = &A[j*n];
+    C[j].P = &P[j*n];
+    C[j].g = g;
+    C[j].s = s;
+    C[j].K = MIN(K, J - j*n);
+    C[j].X = &X[j*n];
+    j++;
+  }
+
+  j = 1;
+  while (j < T) {
+    pthread_create(&th[j], NULL, runChain, &C[j]);
+    j++;
+  }
+  if (0 < T)
+    runChain(&C[0]);
+  j = 1;
+  while (j < T) {
+    pthread_join(th[j], NULL);
+    j++;
+  }
+
+  free(th);
+  free(C);
+}
+
+void
+mixInterleaved(forest* A,
+               int** P,
+               graph g,
+               long long s,
+               int K,
+               struct rng* X
+               )
+{
+  struct lane* L;
+  struct lane* c;
+  edge* E;
+  int e;
+  int V;
+  int k;
+  int a;
+  int o; /* Oldest slot, executed in this round */
+  int x;
+  int i;
+
+  e = edgesNr(g);
+  E = edges(g);
+  V = 0;
+  if (0 < K)
+    V = forestVertexNr(A[0]);
+  if (0 < K && e > V-1) {
+    L = (struct lane*) malloc(K*sizeof(struct lane));
+    k = 0;
+    while (k < K) { /* Fill the slots, their loads are issued later */
+      c = &L[k];
+      c->A = A[k];
+      c->P = P[k];
+      c->X = &X[k];
+      c->h = LANE-1;
+      a = 0;
+      while (a < LANE) {
+        c->j[a] = rngUniform(c->X, e-(V-1)) + (V-1);
+        c->w[a][0] = 0;
+        c->w[a][1] = 0;
+        a++;
+      }
+      k++;
+    }
+
+    while (0 < s) {
+      k = 0;
+      while (k < K) {
+        c = &L[k];
+        o = (c->h + 1) % LANE;
+        stepAt(c->A, c->P, g, c->j[o], c->X);
+
+        /* The executed slot takes a new step, the others move one stage
+           ahead. Each stage loads what the previous one prefetched, so
+           the misses of a chain overlap the work of the other chains. */
+        c->j[o] = rngUniform(c->X, e-(V-1)) + (V-1);
+        __builtin_prefetch(&c->P[c->j[o]]);
+        c->h = o;
+
+        a = (o + LANE - 1) % LANE; /* Age 1, the edge and its Pi entry */
+        i = c->P[c->j[a]];
+        __builtin_prefetch(&E[i]);
+        __builtin_prefetch(&c->P[e + i]);
+
+        a = (o + LANE - 2) % LANE; /* Age 2, the endpoints */
+        i = c->P[c->j[a]];
+        c->w[a][0] = E[i][0];
+        c->w[a][1] = E[i][1];
+        forestPrefetch(c->A, c->w[a][0]);
+        forestPrefetch(c->A, c->w[a][1]);
+
+        x = 3;
+        while (x < LANE - 1) { /* Older ages, one node further up */
+          a = (o + LANE - x) % LANE;
+          i = 0;
+          while (i < 2) {
+            if (0 != c->w[a][i])
+              c->w[a][i] = forestAbove(c->A, c->w[a][i]);
+            if (0 != c->w[a][i])
+              forestPrefetch(c->A, c->w[a][i]);
+            i++;
+          }
+          x++;
+        }
+        k++;
+      }
+      s--;
+    }
+
+    free(L);
+  }
+}
+
+void
+weighForest(forest A,
+            int* P,
+            graph g,
+            double* R
+            )
+{
+  int j;
+  int V;
+  edge* E;
+
+  V = forestVertexNr(A);
+  E = edges(g);
+  j = 0;
+  while (j < V-1) { /* The tree edges */
+    forestWeigh(A, E[P[j]][0], E[P[j]][1], R[P[j]]);
+    j++;
+  }
+}
+
+void
+stepWeighted(forest A,
+             int* P,
+             graph g,
+             double* R,
+             struct rng* X
+             )
+{
+  int i;
+  int j;
+  int ou;
+  int ov;
+  int e;
+  int V;
+  edge* E;
+
+  e = edgesNr(g);
+  V = forestVertexNr(A);
+  E = edges(g);
+  j = rngUniform(X, e-(V-1));
+  j += (V-1);
+  i = P[j];
+  i = forestWeightedSwap(A, E[i][0], E[i][1], i, R[i], rngDouble(X), &ou, &ov);
+  if (0 <= i)
+    pSwap(P, e, j, P[e + i]);
+}
+
+void
+mixWeighted(forest A,
+            int* P,
+            graph g,
+            double* R,
+            long long s,
+            struct rng* X
+            )
+{
+  while (0 < s){
+    stepWeighted(A, P, g, R, X);
     s--;
   }
 }
 
+treeWriter
+startWriter(forest A,
+            FILE* out
+            )
+{
+  treeWriter w;
+
+  w = (treeWriter) malloc(sizeof(struct treeWriter));
+  w->A = A;
+  w->out = out;
+  w->s = NULL;
+  w->busy = 0;
+  w->stop = 0;
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->done, NULL);
+  pthread_create(&w->th, NULL, writerWork, w);
+
+  return w;
+}
+
+void
+writeTree(treeWriter w
+          )
+{
+  writerIdle(w);
+  w->s = forestSnapshot(w->A);
+  pthread_mutex_lock(&w->lock);
+  w->busy = 1;
+  pthread_cond_broadcast(&w->done);
+  pthread_mutex_unlock(&w->lock);
+}
+
+void
+stopWriter(treeWriter w
+           )
+{
+  writerIdle(w);
+  pthread_mutex_lock(&w->lock);
+  w->stop = 1;
+  pthread_cond_broadcast(&w->done);
+  pthread_mutex_unlock(&w->lock);
+  pthread_join(w->th, NULL);
+
+  pthread_cond_destroy(&w->done);
+  pthread_mutex_destroy(&w->lock);
+  free(w);
+}
+
 int *
 initPermutation(graph G  /** [in] */
 		)
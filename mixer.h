@@ -32,38 +32,138 @@
 
 #include <stdint.h>
 #include "graph.h"
-#include "linkCutTree.h"
+#include "dynamicForest.h"
+#include "rng.h"
 
 /* #warning "TODO: Mark with this." */
 /*** typedefs(not structures) and defined constants *******/
 
+typedef struct treeWriter* treeWriter; /** Thread that prints trees. */
+
 /*** enums ************************************************/
 
 /*** structures declarations (only if really necessary) ***/
 
 /*** declarations of public functions (first inlines) *****/
 
-/** @return A "biased" spanning tree over g */
-LCT
-loadLCT(graph g /** [in] */,
-        int* P /** [in/out] load Ex array if alloced. */
-        );
+/** Computes the initial spanning tree of loadForest, as the parent and
+    the edge to the parent of each vertex, and P when it is not NULL. */
+void
+initialTree(graph g /** [in] */,
+            int* P /** [out] Ex array, 2*edgesNr(g) entries, or NULL */,
+            int* parent /** [out] Indexed 1 to V, 0 at roots */,
+            int* id /** [out] Indexed 1 to V */
+            );
+
+/** @return A "biased" spanning tree over g. When g was mapped from a
+    graph file that holds the tree, it is built from the file. */
+forest
+loadForest(graph g /** [in] */,
+           int* P /** [in/out] load Ex array if alloced. */,
+           forestKind k /** [in] Backend of the forest */
+           );
 
 /** Executes one step of the mixing procedure. */
 void
-step(LCT A /** [in/out] */,
+step(forest A /** [in/out] */,
      int* P /** [in/out] Excluded edges. */,
-     graph g /** [in] */
+     graph g /** [in] */,
+     struct rng* R /** [in/out] */
      );
 
 /** Executes a fixed amount of mixing steps. */
 void
-mixFixed(LCT A /** [in/out] */,
+mixFixed(forest A /** [in/out] */,
          int* P /** [in/out] */,
          graph g /** [in] */,
-         int s /** [in] The number of steps. */
+         long long s /** [in] The number of steps. */,
+         struct rng* R /** [in/out] */
          );
 
+/** Executes s mixing steps on each of the J chains (A[j], P[j]),
+    concurrently. Each thread runs K consecutive chains, with
+    mixInterleaved, or one chain with mixFixed when K is 0. Chain j only draws from X[j], so the trees
+    do not depend on how the threads are scheduled. The chains share g and
+    nothing else. */
+void
+mixChains(forest* A /** [in/out] Trees, see cloneForest */,
+          int** P /** [in/out] Permutations, one per chain */,
+          graph g /** [in] */,
+          long long s /** [in] The number of steps of each chain. */,
+          int J /** [in] The number of chains. */,
+          int K /** [in] The number of chains per thread, or 0. */,
+          struct rng* X /** [in/out] Generators, one per chain */
+          );
+
+/** Executes s mixing steps on each of the K chains (A[k], P[k]), in the
+    calling thread. The chains take turns, one step each. Every chain
+    draws its steps well ahead and prefetches, in stages, the permutation,
+    the edge, and the nodes from the endpoints up towards the root, so
+    that its cache misses overlap with the work of the steps before. This
+    pays off even for K = 1, more chains add work to overlap with but
+    share the cache. The chains follow the
+    same distribution as mixFixed, but draw in another order, so the
+    trees differ from those of mixFixed with the same generator. */
+void
+mixInterleaved(forest* A /** [in/out] Trees, see cloneForest */,
+               int** P /** [in/out] Permutations, must not be NULL */,
+               graph g /** [in] */,
+               long long s /** [in] The number of steps of each chain. */,
+               int K /** [in] The number of chains. */,
+               struct rng* X /** [in/out] Generators, one per chain */
+               );
+
+/** @return A thread that prints the trees of A to out, as displayForest,
+    while the chain goes on. The backend must take snapshots, see
+    forestSnapshotQ. */
+treeWriter
+startWriter(forest A /** [in] */,
+            FILE* out /** [in] */
+            );
+
+/** Hands a snapshot of the current tree to w, which prints it while the
+    caller keeps changing the tree. Waits for the previous tree first, so
+    a snapshot only logs the changes of one tree. */
+void
+writeTree(treeWriter w /** [in/out] */
+          );
+
+/** Waits for the last tree and stops w. */
+void
+stopWriter(treeWriter w /** [in] */
+           );
+
+/** Sets the weights of the tree edges, given by P, from R. Call after
+    loadForest, or when the weights change. */
+void
+weighForest(forest A /** [in/out] Must keep weights, see forestWeightedQ */,
+            int* P /** [in] */,
+            graph g /** [in] */,
+            double* R /** [in] Resistances, 1/w, indexed as the edges */
+            );
+
+/** Executes one step of the weighted chain. A non tree edge e is drawn
+    uniformly and one edge f of the cycle it closes, e included, is
+    removed with probability proportional to 1/w(f). This samples trees
+    with probability proportional to the product of their weights. */
+void
+stepWeighted(forest A /** [in/out] */,
+             int* P /** [in/out] Must not be NULL. */,
+             graph g /** [in] */,
+             double* R /** [in] Resistances, 1/w, indexed as the edges */,
+             struct rng* X /** [in/out] */
+             );
+
+/** Executes a fixed amount of weighted mixing steps. */
+void
+mixWeighted(forest A /** [in/out] */,
+            int* P /** [in/out] */,
+            graph g /** [in] */,
+            double* R /** [in] */,
+            long long s /** [in] The number of steps. */,
+            struct rng* X /** [in/out] */
+            );
+
 int *
 initPermutation(graph G  /** [in] */
 		);
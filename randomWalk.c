@@ -26,7 +26,10 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 #include "graph.h"
+#include "rng.h"
+#include "hugeAlloc.h"
 
 #define STR_(X) #X
 #define STR(X) STR_(X)
@@ -34,10 +37,37 @@
 int
 main(int argc, char **argv)
 {
-  if(3 != argc && 4 != argc){
+  int pages = HUGE_NONE; /* Pages of the graph, see hugeAlloc.h */
+  int numa = 0; /* Interleave the graph over the NUMA nodes */
+  uint64_t seed = 0; /* Seed of the generator */
+  int seeded = 0; /* Was -s given */
+  int jobs = 1; /* Threads */
+  int format = GRAPH_AUTO; /* Format of <input>, see graph.h */
+  int opt;
+
+  while(-1 != (opt = getopt(argc, argv, "j:s:H:IF:"))){
+    if('H' == opt)
+      pages = hugeKindOf(optarg);
+    else if('I' == opt)
+      numa = 1;
+    else if('j' == opt)
+      jobs = atoi(optarg);
+    else if('s' == opt){
+      seed = strtoull(optarg, NULL, 10);
+      seeded = 1;
+    }
+    else if('F' == opt)
+      format = graphFormatOf(optarg);
+    else
+      pages = -1;
+  }
+  argc -= optind-1;
+  argv += optind-1;
+
+  if((3 != argc && 4 != argc) || -1 == pages || -1 == format || 1 > jobs){
     printf("SYNOPSIS\n");
     printf("\n");
-    printf("./randomWalk <input> <output> [<repetitions>]\n");
+    printf("./randomWalk [-j <threads>] [-s <seed>] [-H none|thp|2M|1G] [-I] [-F auto|text|snap|metis|mtx] <input> <output> [<repetitions>]\n");
     printf("\n");
     printf("DESCRIPTION\n");
     printf("\n");
@@ -51,6 +81,27 @@ main(int argc, char **argv)
     printf("\n");
     printf("These spanning trees are generated using the random walk algorithm.\n");
     printf("\n");
+    printf("The -F option reads <input> as text, SNAP edge lists, METIS\n");
+    printf("adjacency lists or Matrix Market files, which may be gzipped. By\n");
+    printf("default the format is told by the first bytes of the file, so -F is\n");
+    printf("only needed for METIS files without comment lines, which are\n");
+    printf("otherwise rejected as text.\n");
+    printf("\n");
+    printf("The -H option maps the graph with transparent huge pages, thp, or\n");
+    printf("with 2M or 1G pages from the hugetlb pool, falling back to smaller\n");
+    printf("pages when these are not available. The -I option interleaves the\n");
+    printf("graph over the NUMA nodes. With either option the pages that each\n");
+    printf("array got are printed after loading.\n");
+    printf("\n");
+    printf("The -j option generates the trees with <threads> threads, each\n");
+    printf("takes the next tree when it is done with the last one. The trees\n");
+    printf("are written in order, and are the same for any number of threads.\n");
+    printf("\n");
+    printf("The -s option seeds the random number generator, so that runs\n");
+    printf("with the same seed and arguments produce the same trees. Without\n");
+    printf("it a seed is read from /dev/urandom. The seed is printed in both\n");
+    printf("cases.\n");
+    printf("\n");
   } else {
     printf("BSD 2-Clause License\n");
     printf("\n");
@@ -82,11 +133,13 @@ main(int argc, char **argv)
     printf("\n");
     printf("\n");
 
+    if(!seeded)
+      seed = rngEntropy();
+
     unsigned long long int iterations = 1;
     if(4 == argc)
       sscanf(argv[3], "%ld", &iterations);  /* Read number of iterations */
 
-    unsigned long long int i = 0; /* Number of executions */
     char *fileName = argv[1];
     FILE *fin = fopen(fileName, "r");
     fileName = argv[2];
@@ -94,33 +147,27 @@ main(int argc, char **argv)
     if(NULL != fin){
       if(NULL != fout){
 	/* Load graph */
-	graph G = loadGraph(fin);
+	hugeSetup(pages, numa);
+	graph G = loadGraphAs(fin, format);
 	fclose(fin);
+	if(NULL != G && graphConnectedQ(G)){
+	  if(HUGE_NONE != pages || numa)
+	    hugeReport(stdout);
 
-	int *A = (int*)malloc(graphVertexNr(G)*sizeof(int));
-	if(NULL != A){
+	  printf("Seed: %llu\n", (unsigned long long)seed);
 	  printf("All Ok. Generating trees.\n");
 
-	  while(i < iterations){
-	    printf("%d\n",i);
-	    randomWalk(G, &A[-1]);
-
-	    int j = 0;
-	    while(j < graphVertexNr(G)){
-	      if(0 != A[j])
-		fprintf(fout, "%d %d\n", j+1, A[j]);
-	      j++;
-	    }
- 	    fprintf(fout, "\n");
-
-	    i++;
-	  }
+	  sampleTrees(G, randomWalk, NULL, 1, seed, iterations, jobs, fout);
+	  fclose(fout);
+	  freeGraph(G);
+	} else if(NULL != G){
 	  fclose(fout);
-	  free(A);
+	  freeGraph(G);
+	  printf("Error: the graph is not connected, or has isolated vertexes\n");
 	} else {
-	  printf("Error reading graph\n");
+	  fclose(fout);
+	  printf("Error reading input file\n");
 	}
-	freeGraph(G);
       } else
 	printf("Error opening output file\n");
     } else
@@ -0,0 +1,186 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Implementation of the pseudo random number generator. */
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rng.h"
+
+/*** file scope macro definitions *************************/
+
+#define ROTL(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+/*** file scope functions declarations (static) ***********/
+
+/** @return The next output of the xoshiro256++ state s. */
+static uint64_t
+next(uint64_t* s /**< [in/out] */
+     );
+
+/** @return The next output of splitmix64, used for seeding. */
+static uint64_t
+splitmix(uint64_t* x /**< [in/out] */
+         );
+
+/*** implementation ***************************************/
+
+static uint64_t
+next(uint64_t* s
+     )
+{
+  uint64_t r;
+  uint64_t t;
+
+  r = ROTL(s[0] + s[3], 23) + s[0];
+  t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = ROTL(s[3], 45);
+
+  return r;
+}
+
+static uint64_t
+splitmix(uint64_t* x
+         )
+{
+  uint64_t z;
+
+  *x += UINT64_C(0x9e3779b97f4a7c15);
+  z = *x;
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+
+  return z ^ (z >> 31);
+}
+
+/* End of Static Functions */
+
+void
+rngRefill(struct rng* R
+          )
+{
+  uint64_t s0; /* The state in locals, so it stays in registers */
+  uint64_t s1;
+  uint64_t s2;
+  uint64_t s3;
+  uint64_t t;
+  int i;
+
+  s0 = R->s[0];
+  s1 = R->s[1];
+  s2 = R->s[2];
+  s3 = R->s[3];
+  i = 0;
+  while (i < RNG_BUF) {
+    R->buf[i] = ROTL(s0 + s3, 23) + s0;
+    t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = ROTL(s3, 45);
+    i++;
+  }
+  R->s[0] = s0;
+  R->s[1] = s1;
+  R->s[2] = s2;
+  R->s[3] = s3;
+  R->k = 0;
+}
+
+void
+rngSeed(struct rng* R,
+        uint64_t seed
+        )
+{
+  R->s[0] = splitmix(&seed);
+  R->s[1] = splitmix(&seed);
+  R->s[2] = splitmix(&seed);
+  R->s[3] = splitmix(&seed);
+  R->k = RNG_BUF;
+}
+
+void
+rngJump(struct rng* R
+        )
+{
+  static const uint64_t J[] = {
+    UINT64_C(0x180ec6d33cfd0aba), UINT64_C(0xd5a61266f0c9392c),
+    UINT64_C(0xa9582618e03fc9aa), UINT64_C(0x39abdc4529b1661c)
+  };
+  uint64_t s[4];
+  int i;
+  int b;
+
+  s[0] = 0;
+  s[1] = 0;
+  s[2] = 0;
+  s[3] = 0;
+  i = 0;
+  while (i < 4) {
+    b = 0;
+    while (b < 64) {
+      if (J[i] & UINT64_C(1) << b) {
+        s[0] ^= R->s[0];
+        s[1] ^= R->s[1];
+        s[2] ^= R->s[2];
+        s[3] ^= R->s[3];
+      }
+      next(R->s);
+      b++;
+    }
+    i++;
+  }
+  R->s[0] = s[0];
+  R->s[1] = s[1];
+  R->s[2] = s[2];
+  R->s[3] = s[3];
+  R->k = RNG_BUF;
+}
+
+uint64_t
+rngEntropy(void
+           )
+{
+  uint64_t r;
+  FILE* f;
+
+  r = 0;
+  f = fopen("/dev/urandom", "r");
+  if (NULL == f || 1 != fread(&r, sizeof(r), 1, f))
+    r = (uint64_t)time(NULL) ^ (uint64_t)getpid() << 32 ^ (uint64_t)clock();
+  if (NULL != f)
+    fclose(f);
+
+  return r;
+}
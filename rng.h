@@ -0,0 +1,114 @@
+/* BSD 2-Clause License */
+
+/* Copyright (c) 2020, Luís M. S. Russo */
+/* All rights reserved. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions are met: */
+
+/* 1. Redistributions of source code must retain the above copyright notice, this */
+/*    list of conditions and the following disclaimer. */
+
+/* 2. Redistributions in binary form must reproduce the above copyright notice, */
+/*    this list of conditions and the following disclaimer in the documentation */
+/*    and/or other materials provided with the distribution. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" */
+/* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE */
+/* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE */
+/* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE */
+/* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL */
+/* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR */
+/* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, */
+/* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE */
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+/** @file Header for the pseudo random number generator.
+
+    Every sampler draws from a struct rng, a xoshiro256++ generator that
+    is seeded explicitly, so runs can be repeated. Its outputs are made in
+    batches of RNG_BUF, and bounded values use Lemire's multiply and
+    reject, which almost never divides. rngJump gives streams that do not
+    overlap, one per thread or per repetition. */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/*** typedefs(not structures) and defined constants *******/
+
+/** Outputs made by each refill. */
+#define RNG_BUF 32
+
+/*** structures declarations (only if really necessary) ***/
+
+struct rng { /** xoshiro256++ state and the outputs not yet used. */
+  uint64_t s[4]; /** State, after the outputs in buf */
+  int k; /** Next value of buf, RNG_BUF when it is empty */
+  uint64_t buf[RNG_BUF]; /** Outputs */
+};
+
+/*** declarations of public functions (first inlines) *****/
+
+/** Fills the buffer of R. */
+void
+rngRefill(struct rng* R /**< [in/out] */
+          );
+
+/** @return The next 64 random bits of R. */
+static inline uint64_t
+rngNext(struct rng* R /**< [in/out] */
+        )
+{
+  if (RNG_BUF == R->k)
+    rngRefill(R);
+  return R->buf[R->k++];
+}
+
+/** @return A uniform value in [0, n[, n > 0. */
+static inline uint32_t
+rngUniform(struct rng* R /**< [in/out] */,
+           uint32_t n /**< [in] */
+           )
+{
+  uint64_t m;
+  uint32_t t;
+
+  m = (rngNext(R) >> 32) * n;
+  if ((uint32_t)m < n) {
+    t = -n % n;
+    while ((uint32_t)m < t)
+      m = (rngNext(R) >> 32) * n;
+  }
+
+  return m >> 32;
+}
+
+/** @return A uniform value in [0, 1[, with 53 random bits. */
+static inline double
+rngDouble(struct rng* R /**< [in/out] */
+          )
+{
+  return (rngNext(R) >> 11) / 9007199254740992.0;
+}
+
+/** Starts R from seed, any value is fine. */
+void
+rngSeed(struct rng* R /**< [out] */,
+        uint64_t seed /**< [in] */
+        );
+
+/** Moves R 2^128 values ahead. A copy of R taken before, and R, then
+    draw streams that do not overlap. */
+void
+rngJump(struct rng* R /**< [in/out] */
+        );
+
+/** @return A seed from /dev/urandom, or from the clock if it fails. */
+uint64_t
+rngEntropy(void
+           );
+
+#endif /* RNG_H */
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Runs the samplers on the graphs of this directory, see make test. Each
+# tree of tests/gapped.snap must hold 3 edges of the renumbered graph,
+# and tests/split.snap must be rejected.
+
+cd "$(dirname "$0")/.." || exit 1
+out=$(mktemp) || exit 1
+trap 'rm -f "$out"' EXIT
+fail=0
+
+for cmd in ./Wilson ./randomWalk ./edgeSwap "./edgeSwap -b ett"; do
+  if ! $cmd -s 1 tests/gapped.snap "$out" 20 > /dev/null \
+      || ! awk 'NF == 0 { if (n != 3) bad = 1; n = 0; t++; next }
+                { u = $1 < $2 ? $1 : $2; v = $1 < $2 ? $2 : $1
+                  if (!((u == 1 && v == 2) || (u == 2 && v == 3) \
+                        || (u == 1 && v == 3) || (u == 3 && v == 4)))
+                    bad = 1
+                  n++ }
+                END { exit bad || t != 20 }' "$out"; then
+    echo "FAIL: $cmd on tests/gapped.snap"
+    fail=1
+  fi
+  if ! $cmd -s 1 tests/split.snap "$out" 1 | grep -q "not connected"; then
+    echo "FAIL: $cmd accepts tests/split.snap"
+    fail=1
+  fi
+done
+
+[ 0 = $fail ] && echo "All tests passed."
+exit $fail